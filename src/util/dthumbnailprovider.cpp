@@ -18,36 +18,264 @@
 #include "dthumbnailprovider.h"
 #include <DObjectPrivate>
 
+#include <QCache>
 #include <QCryptographicHash>
 #include <QDir>
 #include <QDateTime>
+#include <QDirIterator>
+#include <QElapsedTimer>
 #include <QImageReader>
 #include <QQueue>
+#include <QSharedPointer>
 #include <QMimeType>
 #include <QMimeDatabase>
+#include <QMutex>
 #include <QReadWriteLock>
 #include <QWaitCondition>
 #include <QPainter>
 #include <QUrl>
 #include <QDebug>
+#include <QtEndian>
 
 #include <DStandardPaths>
 
+#include <algorithm>
+
+#ifdef Q_OS_UNIX
+#include <fcntl.h>
+#include <stdio.h>
+#include <unistd.h>
+#endif
+
+#ifdef Q_OS_LINUX
+#include <sys/syscall.h>
+#endif
+
 DWIDGET_BEGIN_NAMESPACE
 
 #define FORMAT ".png"
 #define THUMBNAIL_PATH \
     DCORE_NAMESPACE::DStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + "/thumbnails"
-#define THUMBNAIL_FAIL_PATH THUMBNAIL_PATH"/fail"
-#define THUMBNAIL_LARGE_PATH THUMBNAIL_PATH"/large"
-#define THUMBNAIL_NORMAL_PATH THUMBNAIL_PATH"/normal"
-#define THUMBNAIL_SMALL_PATH THUMBNAIL_PATH"/small"
+#define THUMBNAIL_DEFAULT_QUALITY 80
 
 inline QByteArray dataToMd5Hex(const QByteArray &data)
 {
     return QCryptographicHash::hash(data, QCryptographicHash::Md5).toHex();
 }
 
+// reads a text chunk of a thumbnail without decoding the image,
+// the text chunks are written before the image data
+static bool readThumbnailText(const QString &fileName, const QByteArray &key, QByteArray *value)
+{
+    QFile file(fileName);
+
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    if (file.read(8) != QByteArray("\x89PNG\r\n\x1a\n", 8))
+    {
+        return false;
+    }
+
+    Q_FOREVER
+    {
+        const QByteArray &header = file.read(8);
+
+        if (header.size() != 8)
+        {
+            return false;
+        }
+
+        quint32 length = qFromBigEndian<quint32>(reinterpret_cast<const uchar *>(header.constData()));
+        const QByteArray &type = header.mid(4);
+
+        if (type == "IDAT" || type == "IEND")
+        {
+            return false;
+        }
+
+        // Qt stores text longer than 40 characters compressed in zTXt chunks
+        if ((type == "tEXt" || type == "zTXt") && length < 64 * 1024)
+        {
+            const QByteArray &data = file.read(length);
+            const int keyEnd = data.indexOf('\0');
+
+            if (keyEnd > 0 && data.left(keyEnd) == key)
+            {
+                if (type == "tEXt")
+                {
+                    *value = data.mid(keyEnd + 1);
+
+                    return true;
+                }
+
+                // skip the compression method, qUncompress expects a size hint before the zlib stream
+                QByteArray compressed(4, '\0');
+                qToBigEndian<quint32>(1024, reinterpret_cast<uchar *>(compressed.data()));
+                compressed.append(data.mid(keyEnd + 2));
+                *value = qUncompress(compressed);
+
+                return !value->isEmpty();
+            }
+
+            length = 0;
+        }
+
+        // skip the chunk data and CRC
+        if (!file.seek(file.pos() + length + 4))
+        {
+            return false;
+        }
+    }
+}
+
+static bool readThumbnailMTime(const QString &fileName, qint64 *mtime)
+{
+    QByteArray value;
+
+    if (!readThumbnailText(fileName, QT_STRINGIFY(Thumb::MTime), &value))
+    {
+        return false;
+    }
+
+    bool ok = false;
+    *mtime = value.toLongLong(&ok);
+
+    return ok;
+}
+
+// decodes the thumbnail stored in the Exif APP1 segment of a JPEG file
+static QImage readExifThumbnail(const QString &fileName)
+{
+    QFile file(fileName);
+
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return QImage();
+    }
+
+    // an APP1 segment is at most 64KB and comes before the image data
+    const QByteArray &data = file.read(128 * 1024);
+    const uchar *p = reinterpret_cast<const uchar *>(data.constData());
+    const qint64 dataSize = data.size();
+
+    if (dataSize < 4 || p[0] != 0xFF || p[1] != 0xD8)
+    {
+        return QImage();
+    }
+
+    qint64 pos = 2;
+    qint64 tiffPos = -1;
+    qint64 tiffSize = 0;
+
+    while (pos + 4 <= dataSize && p[pos] == 0xFF)
+    {
+        const uchar marker = p[pos + 1];
+
+        // start of scan or end of image
+        if (marker == 0xDA || marker == 0xD9)
+        {
+            break;
+        }
+
+        const qint64 length = qFromBigEndian<quint16>(p + pos + 2);
+
+        if (marker == 0xE1 && length >= 8 && pos + 2 + length <= dataSize
+                && memcmp(p + pos + 4, "Exif\0\0", 6) == 0)
+        {
+            tiffPos = pos + 10;
+            tiffSize = length - 8;
+            break;
+        }
+
+        pos += 2 + length;
+    }
+
+    if (tiffPos < 0 || tiffSize < 8)
+    {
+        return QImage();
+    }
+
+    const uchar *tiff = p + tiffPos;
+    bool littleEndian = false;
+
+    if (tiff[0] == 'I' && tiff[1] == 'I')
+    {
+        littleEndian = true;
+    }
+    else if (tiff[0] != 'M' || tiff[1] != 'M')
+    {
+        return QImage();
+    }
+
+    auto read16 = [tiff, littleEndian] (qint64 offset) -> qint64 {
+        return littleEndian ? qFromLittleEndian<quint16>(tiff + offset) : qFromBigEndian<quint16>(tiff + offset);
+    };
+    auto read32 = [tiff, littleEndian] (qint64 offset) -> qint64 {
+        return littleEndian ? qFromLittleEndian<quint32>(tiff + offset) : qFromBigEndian<quint32>(tiff + offset);
+    };
+
+    // IFD1 follows IFD0 and describes the thumbnail
+    const qint64 ifd0 = read32(4);
+
+    if (ifd0 + 2 > tiffSize)
+    {
+        return QImage();
+    }
+
+    const qint64 nextIfd = ifd0 + 2 + read16(ifd0) * 12;
+
+    if (nextIfd + 4 > tiffSize)
+    {
+        return QImage();
+    }
+
+    const qint64 ifd1 = read32(nextIfd);
+
+    if (ifd1 == 0 || ifd1 + 2 > tiffSize)
+    {
+        return QImage();
+    }
+
+    const qint64 entryCount = read16(ifd1);
+    qint64 thumbnailOffset = 0;
+    qint64 thumbnailLength = 0;
+
+    for (qint64 i = 0; i < entryCount; ++i)
+    {
+        const qint64 entry = ifd1 + 2 + i * 12;
+
+        if (entry + 12 > tiffSize)
+        {
+            break;
+        }
+
+        const qint64 tag = read16(entry);
+
+        // JPEGInterchangeFormat and JPEGInterchangeFormatLength
+        if (tag == 0x0201)
+        {
+            thumbnailOffset = read32(entry + 8);
+        }
+        else if (tag == 0x0202)
+        {
+            thumbnailLength = read32(entry + 8);
+        }
+    }
+
+    if (thumbnailOffset <= 0 || thumbnailLength <= 0 || thumbnailOffset + thumbnailLength > tiffSize)
+    {
+        return QImage();
+    }
+
+    return QImage::fromData(tiff + thumbnailOffset, static_cast<int>(thumbnailLength), "JPEG");
+}
+
+class DThumbnailWorker;
+class DThumbnailWriter;
+class DThumbnailCollector;
 class DThumbnailProviderPrivate : public DTK_CORE_NAMESPACE::DObjectPrivate
 {
 public:
@@ -55,35 +283,199 @@ public:
 
     void init();
 
+    QString thumbnailPath() const;
+    QString failPath() const;
+    bool isThumbnailPath(const QString &absolutePath) const;
     QString sizeToFilePath(DThumbnailProvider::Size size) const;
+    bool readImage(QImageReader &reader, const QSize &imageSize, DThumbnailProvider::Size size, QImage *image);
+    void recordDecodeStage(DThumbnailProvider::DecodeStage stage, qint64 nsecs);
+
+    QAtomicInteger<qint64> decodeStageTime[DThumbnailProvider::FullDecodeStage + 1];
+    QAtomicInt decodeStageCount[DThumbnailProvider::FullDecodeStage + 1];
 
+    void setErrorString(const QString &error);
+
+    // errorString() reports the last error of any thread, it is set before the
+    // result is emitted or passed to the callback
+    mutable QMutex errorLock;
     QString errorString;
     // MAX
     qint64 defaultSizeLimit = INT64_MAX;
     QHash<QMimeType, qint64> sizeLimitHash;
     QMimeDatabase mimeDatabase;
 
-    static QSet<QString> hasThumbnailMimeHash;
+    static const QSet<QString> &hasThumbnailMimeHash();
+    QMimeType mimeTypeForFile(const QFileInfo &info) const;
+
+    // validated thumbnails of (source file path, size), the cost is in kilobytes
+    struct ThumbnailCacheEntry
+    {
+        QString thumbnailPath;
+        qint64 sourceMTime;
+        QDateTime thumbnailMTime;
+        QImage image;
+    };
+    typedef QPair<QString, int> ThumbnailCacheKey;
+
+    void insertCache(const QString &sourceFilePath, DThumbnailProvider::Size size, const QString &thumbnailPath,
+                     qint64 sourceMTime, const QImage &image = QImage()) const;
+    void removeCache(const QString &sourceFilePath) const;
+
+    mutable QMutex cacheLock;
+    mutable QCache<ThumbnailCacheKey, ThumbnailCacheEntry> thumbnailCache;
 
     struct ProduceInfo
     {
         QFileInfo fileInfo;
         DThumbnailProvider::Size size;
         DThumbnailProvider::CallBack callback;
+        DThumbnailProvider::Priority priority;
+        // priority given by the caller, restored when the file leaves the viewport
+        DThumbnailProvider::Priority requestedPriority;
+        // guarded by taskLock, discarded tasks are dropped when a worker reaches them
+        bool discarded = false;
+    };
+    typedef QSharedPointer<ProduceInfo> ProduceTask;
+
+    // every worker owns a queue per priority, it takes tasks from the front of its own queue
+    // and steals from the back of the others when it runs out of work of that priority
+    struct ProduceQueue
+    {
+        QMutex mutex;
+        QQueue<ProduceTask> tasks[DThumbnailProvider::VisiblePriority + 1];
+    };
+
+    void startWorkers();
+    void enqueue(const ProduceTask &task);
+    void requeue(const QString &filePath, DThumbnailProvider::Priority priority);
+    void requeue(ProduceTask &task, DThumbnailProvider::Priority priority);
+    void restorePriority(const QString &filePath);
+    bool takeTask(int index, ProduceTask *task);
+    void workerLoop(int index);
+
+    // worker 0 is the DThumbnailProvider thread itself
+    QList<DThumbnailWorker*> workers;
+    QList<ProduceQueue*> produceQueues;
+    QReadWriteLock poolLock;
+    int workerCount = qMax(1, QThread::idealThreadCount());
+    QAtomicInt nextQueue;
+    QAtomicInt pendingCount;
+
+    // index of the queued tasks by source file path, cancelling and reprioritizing
+    // a task only marks it discarded instead of searching the queues
+    QMutex taskLock;
+    QHash<QString, QList<ProduceTask>> pendingTasks;
+    // priorities assigned by setViewportFiles
+    QHash<QString, DThumbnailProvider::Priority> viewportPriorities;
+
+    // a decoded thumbnail waiting to be written to the cache
+    struct WriteTask
+    {
+        QString sourceFilePath;
+        DThumbnailProvider::Size size;
+        qint64 sourceMTime;
+        QString thumbnailPath;
+        QImage image;
+        QString errorString;
+        DThumbnailProvider::CallBack callback;
+        bool privateCache = false;
     };
 
-    QQueue<ProduceInfo> produceQueue;
-    QSet<QPair<QString, DThumbnailProvider::Size>> discardedProduceInfos;
+    bool prepareThumbnail(const QFileInfo &info, DThumbnailProvider::Size size, WriteTask *task, QString *result);
+    void writeThumbnails(QList<WriteTask> &tasks);
+    QString finishThumbnail(const WriteTask &task);
+    void enqueueWrite(WriteTask &&task);
+    void writerLoop();
+
+    // the writer thread saves thumbnails while the workers decode the next files
+    DThumbnailWriter *writer = nullptr;
+    QQueue<WriteTask> writeQueue;
+    QMutex writeMutex;
+    QWaitCondition writeCondition;
+    // written by setSaveQuality() on the caller's thread, read by the writer thread
+    QAtomicInt saveQuality {THUMBNAIL_DEFAULT_QUALITY};
+
+    // an empty directory is the shared freedesktop cache
+    mutable QMutex cacheDirectoryLock;
+    QString cacheDirectory;
+
+    void startGarbageCollection(bool force);
+    void collectGarbage();
+
+    // evicts thumbnails beyond the disk budget on an idle priority thread
+    DThumbnailCollector *collector = nullptr;
+    QMutex collectMutex;
+    QElapsedTimer lastCollectTimer;
+    // 1GB
+    qint64 diskCacheLimit = 1024LL * 1024 * 1024;
+    int diskCacheEntryLimit = 0;
 
     bool running = true;
 
+    QMutex waitMutex;
     QWaitCondition waitCondition;
-    QReadWriteLock dataReadWriteLock;
 
     D_DECLARE_PUBLIC(DThumbnailProvider)
 };
 
-QSet<QString> DThumbnailProviderPrivate::hasThumbnailMimeHash;
+class DThumbnailWorker : public QThread
+{
+public:
+    DThumbnailWorker(DThumbnailProviderPrivate *d, int index)
+        : d(d)
+        , index(index)
+    {
+
+    }
+
+protected:
+    void run() Q_DECL_OVERRIDE
+    {
+        d->workerLoop(index);
+    }
+
+private:
+    DThumbnailProviderPrivate *d;
+    int index;
+};
+
+class DThumbnailWriter : public QThread
+{
+public:
+    explicit DThumbnailWriter(DThumbnailProviderPrivate *d)
+        : d(d)
+    {
+
+    }
+
+protected:
+    void run() Q_DECL_OVERRIDE
+    {
+        d->writerLoop();
+    }
+
+private:
+    DThumbnailProviderPrivate *d;
+};
+
+class DThumbnailCollector : public QThread
+{
+public:
+    explicit DThumbnailCollector(DThumbnailProviderPrivate *d)
+        : d(d)
+    {
+
+    }
+
+protected:
+    void run() Q_DECL_OVERRIDE
+    {
+        d->collectGarbage();
+    }
+
+private:
+    DThumbnailProviderPrivate *d;
+};
 
 DThumbnailProviderPrivate::DThumbnailProviderPrivate(DThumbnailProvider *qq)
     : DObjectPrivate(qq)
@@ -93,82 +485,940 @@ DThumbnailProviderPrivate::DThumbnailProviderPrivate(DThumbnailProvider *qq)
 
 void DThumbnailProviderPrivate::init()
 {
+    produceQueues.append(new ProduceQueue());
+    // 64MB
+    thumbnailCache.setMaxCost(64 * 1024);
+    // the first automatic collection runs an hour after start, not on the first queued file
+    lastCollectTimer.start();
+}
+
+const QSet<QString> &DThumbnailProviderPrivate::hasThumbnailMimeHash()
+{
+    // initialized once, workers and the GUI thread may race for it
+    static const QSet<QString> mimeHash = [] {
+        QSet<QString> hash;
+        const QList<QByteArray> &mimeTypes = QImageReader::supportedMimeTypes();
+
+        hash.reserve(mimeTypes.size());
+
+        for (const QByteArray &t : mimeTypes)
+        {
+            hash.insert(QString::fromLocal8Bit(t));
+        }
+
+        return hash;
+    }();
 
+    return mimeHash;
 }
 
-QString DThumbnailProviderPrivate::sizeToFilePath(DThumbnailProvider::Size size) const
+// classify by the glob patterns of the whole file name first, sniffing the content
+// is only needed for files no pattern or several patterns match
+QMimeType DThumbnailProviderPrivate::mimeTypeForFile(const QFileInfo &info) const
 {
-    switch (size)
+    const QList<QMimeType> &mimeTypes = mimeDatabase.mimeTypesForFileName(info.fileName());
+
+    if (mimeTypes.size() == 1)
     {
-    case DThumbnailProvider::Small:
-        return THUMBNAIL_SMALL_PATH;
-    case DThumbnailProvider::Normal:
-        return THUMBNAIL_NORMAL_PATH;
-    case DThumbnailProvider::Large:
-        return THUMBNAIL_LARGE_PATH;
+        return mimeTypes.first();
     }
 
-    return QString();
+    return mimeDatabase.mimeTypeForFile(info);
 }
 
-class DFileThumbnailProviderPrivate : public DThumbnailProvider {};
-Q_GLOBAL_STATIC(DFileThumbnailProviderPrivate, ftpGlobal)
+void DThumbnailProviderPrivate::insertCache(const QString &sourceFilePath, DThumbnailProvider::Size size, const QString &thumbnailPath,
+                                            qint64 sourceMTime, const QImage &image) const
+{
+    ThumbnailCacheEntry *entry = new ThumbnailCacheEntry();
 
-DThumbnailProvider *DThumbnailProvider::instance()
+    entry->thumbnailPath = thumbnailPath;
+    entry->sourceMTime = sourceMTime;
+    entry->thumbnailMTime = QFileInfo(thumbnailPath).lastModified();
+    entry->image = image;
+
+    const int cost = qMax(1, image.bytesPerLine() * image.height() / 1024);
+
+    QMutexLocker locker(&cacheLock);
+    Q_UNUSED(locker)
+
+    thumbnailCache.insert(qMakePair(sourceFilePath, static_cast<int>(size)), entry, cost);
+}
+
+void DThumbnailProviderPrivate::removeCache(const QString &sourceFilePath) const
 {
-    return ftpGlobal;
+    QMutexLocker locker(&cacheLock);
+    Q_UNUSED(locker)
+
+    for (DThumbnailProvider::Size size : {DThumbnailProvider::Small, DThumbnailProvider::Normal, DThumbnailProvider::Large})
+    {
+        thumbnailCache.remove(qMakePair(sourceFilePath, static_cast<int>(size)));
+    }
 }
 
-bool DThumbnailProvider::hasThumbnail(const QFileInfo &info) const
+void DThumbnailProviderPrivate::startWorkers()
 {
-    Q_D(const DThumbnailProvider);
+    Q_Q(DThumbnailProvider);
+
+    QList<DThumbnailWorker*> pendingWorkers;
 
-    if (!info.isReadable() || !info.isFile())
     {
-        return false;
+        QWriteLocker locker(&poolLock);
+
+        while (produceQueues.size() < workerCount)
+        {
+            produceQueues.append(new ProduceQueue());
+        }
+
+        while (workers.size() < workerCount - 1)
+        {
+            workers.append(new DThumbnailWorker(this, workers.size() + 1));
+        }
+
+        pendingWorkers = workers.mid(0, workerCount - 1);
     }
 
-    qint64 fileSize = info.size();
+    if (!q->isRunning())
+    {
+        q->start();
+    }
 
-    if (fileSize <= 0)
+    for (DThumbnailWorker *worker : pendingWorkers)
     {
-        return false;
+        if (!worker->isRunning())
+        {
+            worker->start();
+        }
+    }
+}
+
+void DThumbnailProviderPrivate::enqueue(const ProduceTask &task)
+{
+    {
+        QReadLocker locker(&poolLock);
+        // only feed the queues of active workers, queues of retired workers are drained by stealing
+        const int count = qMin(workerCount, produceQueues.size());
+        ProduceQueue *queue = produceQueues.at(static_cast<uint>(nextQueue.fetchAndAddRelaxed(1)) % count);
+
+        QMutexLocker queueLocker(&queue->mutex);
+        queue->tasks[task->priority].append(task);
     }
 
-    const QMimeType &mime = d->mimeDatabase.mimeTypeForFile(info);
+    pendingCount.ref();
 
-    if (fileSize > sizeLimit(mime))
+    QMutexLocker locker(&waitMutex);
+    Q_UNUSED(locker)
+    waitCondition.wakeOne();
+}
+
+// must be called with taskLock held
+void DThumbnailProviderPrivate::requeue(const QString &filePath, DThumbnailProvider::Priority priority)
+{
+    auto it = pendingTasks.find(filePath);
+
+    if (it == pendingTasks.end())
     {
-        return false;
+        return;
     }
 
-    return hasThumbnail(mime);
+    for (ProduceTask &task : it.value())
+    {
+        requeue(task, priority);
+    }
 }
 
-bool DThumbnailProvider::hasThumbnail(const QMimeType &mimeType) const
+// must be called with taskLock held
+void DThumbnailProviderPrivate::requeue(ProduceTask &task, DThumbnailProvider::Priority priority)
+{
+    if (task->priority == priority)
+    {
+        return;
+    }
+
+    // the old entry stays in its queue and is dropped when reached
+    ProduceTask newTask(new ProduceInfo(*task));
+    newTask->priority = priority;
+    task->discarded = true;
+    task = newTask;
+    enqueue(newTask);
+}
+
+// must be called with taskLock held
+void DThumbnailProviderPrivate::restorePriority(const QString &filePath)
 {
-    const QString &mime = mimeType.name();
+    auto it = pendingTasks.find(filePath);
 
-    if (DThumbnailProviderPrivate::hasThumbnailMimeHash.isEmpty())
+    if (it == pendingTasks.end())
     {
-        const QList<QByteArray> &mimeTypes = QImageReader::supportedMimeTypes();
+        return;
+    }
+
+    for (ProduceTask &task : it.value())
+    {
+        requeue(task, task->requestedPriority);
+    }
+}
+
+bool DThumbnailProviderPrivate::takeTask(int index, ProduceTask *task)
+{
+    QList<ProduceQueue*> queues;
+
+    {
+        // queues are only deleted with the provider, do not hold poolLock while taking taskLock
+        QReadLocker locker(&poolLock);
+        queues = produceQueues;
+    }
 
-        if (mimeTypes.isEmpty())
+    const int count = queues.size();
+
+    for (int priority = DThumbnailProvider::VisiblePriority; priority >= DThumbnailProvider::LowPriority; --priority)
+    {
+        for (int i = 0; i < count; ++i)
         {
-            DThumbnailProviderPrivate::hasThumbnailMimeHash.insert("");
+            ProduceQueue *queue = queues.at((index + i) % count);
 
-            return false;
-        }
+            Q_FOREVER
+            {
+                ProduceTask candidate;
+
+                {
+                    QMutexLocker queueLocker(&queue->mutex);
+                    QQueue<ProduceTask> &tasks = queue->tasks[priority];
+
+                    if (tasks.isEmpty())
+                    {
+                        break;
+                    }
+
+                    candidate = i == 0 ? tasks.takeFirst() : tasks.takeLast();
+                }
+
+                pendingCount.deref();
+
+                QMutexLocker taskLocker(&taskLock);
+
+                if (candidate->discarded)
+                {
+                    continue;
+                }
+
+                auto it = pendingTasks.find(candidate->fileInfo.absoluteFilePath());
+
+                if (it != pendingTasks.end())
+                {
+                    it.value().removeOne(candidate);
+
+                    if (it.value().isEmpty())
+                    {
+                        pendingTasks.erase(it);
+                    }
+                }
+
+                *task = candidate;
+
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+void DThumbnailProviderPrivate::workerLoop(int index)
+{
+    Q_FOREVER
+    {
+        if (!running)
+        {
+            return;
+        }
+
+        ProduceTask task;
+
+        if (!takeTask(index, &task))
+        {
+            QMutexLocker locker(&waitMutex);
+
+            if (!running || index >= workerCount)
+            {
+                return;
+            }
+
+            if (pendingCount.load() <= 0)
+            {
+                waitCondition.wait(&waitMutex);
+            }
+
+            continue;
+        }
+
+        DThumbnailProviderPrivate::WriteTask writeTask;
+        QString thumbnail;
+
+        if (prepareThumbnail(task->fileInfo, task->size, &writeTask, &thumbnail))
+        {
+            writeTask.callback = task->callback;
+            enqueueWrite(std::move(writeTask));
+
+            continue;
+        }
+
+        setErrorString(writeTask.errorString);
+
+        if (task->callback)
+        {
+            task->callback(thumbnail);
+        }
+    }
+}
+
+// decodes the thumbnail of info into task, returns false when nothing has to be
+// written and result already holds the thumbnail path to return
+bool DThumbnailProviderPrivate::prepareThumbnail(const QFileInfo &info, DThumbnailProvider::Size size, WriteTask *task, QString *result)
+{
+    Q_Q(DThumbnailProvider);
+
+    const QString &absolutePath = info.absolutePath();
+    const QString &absoluteFilePath = info.absoluteFilePath();
+
+    if (isThumbnailPath(absolutePath))
+    {
+        *result = absoluteFilePath;
+
+        return false;
+    }
+
+    if (!q->hasThumbnail(info))
+    {
+        task->errorString = QStringLiteral("This file has not support thumbnail: ") + absoluteFilePath;
+
+        //!Warnning: Do not store thumbnails to the fail path
+        return false;
+    }
+
+    const QString fileUrl = QUrl::fromLocalFile(absoluteFilePath).toString(QUrl::FullyEncoded);
+    const QString thumbnailName = dataToMd5Hex(fileUrl.toLocal8Bit()) + FORMAT;
+    const qint64 sourceMTime = info.lastModified().toTime_t();
+
+    // the file is in fail path
+    QString thumbnail = failPath() + QDir::separator() + thumbnailName;
+
+    if (QFile::exists(thumbnail))
+    {
+        qint64 thumbnailMTime = 0;
+
+        if (!readThumbnailMTime(thumbnail, &thumbnailMTime) || thumbnailMTime != sourceMTime)
+        {
+            QFile::remove(thumbnail);
+        }
+        else
+        {
+            return false;
+        }
+    }// end
+
+    QString &errorString = task->errorString;
+    QImage image(QSize(size, size), QImage::Format_ARGB32_Premultiplied);
+    QImageReader reader(absoluteFilePath);
+
+    if (!reader.canRead())
+    {
+        reader.setFormat(mimeDatabase.mimeTypeForFile(info).name().toLocal8Bit());
+
+        if (!reader.canRead())
+        {
+            errorString = reader.errorString();
+        }
+    }
+
+    if (errorString.isEmpty())
+    {
+        const QSize &imageSize = reader.size();
+
+        if (imageSize.isValid())
+        {
+            if (!readImage(reader, imageSize, size, &image))
+            {
+                errorString = reader.errorString();
+            }
+        }
+        else
+        {
+            errorString = "Fail to read image file attribute data:" + info.absoluteFilePath();
+        }
+    }
+
+    // successful
+    if (errorString.isEmpty())
+    {
+        thumbnail = sizeToFilePath(size) + QDir::separator() + thumbnailName;
+    }
+    else
+    {
+        //fail
+        image = QImage(1, 1, QImage::Format_Mono);
+    }
+
+    image.setText(QT_STRINGIFY(Thumb::URL), fileUrl);
+    image.setText(QT_STRINGIFY(Thumb::MTime), QString::number(sourceMTime));
+
+    task->sourceFilePath = absoluteFilePath;
+    task->size = size;
+    task->sourceMTime = sourceMTime;
+    task->thumbnailPath = thumbnail;
+    task->image = image;
+
+    {
+        QMutexLocker locker(&cacheDirectoryLock);
+        task->privateCache = !cacheDirectory.isEmpty();
+    }
+
+    return true;
+}
+
+// saves a batch of thumbnails, each one goes to a temporary file that is only renamed
+// over the thumbnail once its data is on disk, so a crash never leaves a truncated PNG
+void DThumbnailProviderPrivate::writeThumbnails(QList<WriteTask> &tasks)
+{
+    const QString &partSuffix = QStringLiteral(".part-%1").arg(reinterpret_cast<quintptr>(QThread::currentThreadId()), 0, 16);
+    QList<QFile*> files;
+    QSet<QString> directories;
+    // a file decoded twice ends up twice in a batch, only the last one is written because
+    // both would use the same temporary file
+    QHash<QString, int> lastTasks;
+
+    for (int i = 0; i < tasks.size(); ++i)
+    {
+        lastTasks.insert(tasks.at(i).thumbnailPath, i);
+    }
+
+    for (int i = 0; i < tasks.size(); ++i)
+    {
+        WriteTask &task = tasks[i];
+
+        if (lastTasks.value(task.thumbnailPath) != i)
+        {
+            files << nullptr;
+            continue;
+        }
+
+        const QString &dirPath = QFileInfo(task.thumbnailPath).absolutePath();
+
+        // create path
+        if (!directories.contains(dirPath))
+        {
+            QDir(dirPath).mkpath(".");
+            directories.insert(dirPath);
+        }
+
+        QFile *file = new QFile(task.thumbnailPath + partSuffix);
+        // other applications share the freedesktop cache, only a private cache uses saveQuality()
+        const int quality = task.privateCache ? saveQuality.loadAcquire() : THUMBNAIL_DEFAULT_QUALITY;
+
+        if (!file->open(QIODevice::WriteOnly | QIODevice::Truncate)
+                || !task.image.save(file, "png", quality)
+                || !file->flush())
+        {
+            task.errorString = QStringLiteral("Can not save image to ") + task.thumbnailPath;
+            file->remove();
+            delete file;
+            file = nullptr;
+        }
+
+        files << file;
+    }
+
+#ifdef Q_OS_UNIX
+    // one sync pass for the whole batch, the kernel has already queued the data of every file
+    for (QFile *file : files)
+    {
+        if (file)
+        {
+            ::fsync(file->handle());
+        }
+    }
+#endif
+
+    for (int i = 0; i < tasks.size(); ++i)
+    {
+        QFile *file = files.at(i);
+
+        if (!file)
+        {
+            continue;
+        }
+
+        file->close();
+
+#ifdef Q_OS_UNIX
+        const bool renamed = ::rename(QFile::encodeName(file->fileName()).constData(),
+                                      QFile::encodeName(tasks.at(i).thumbnailPath).constData()) == 0;
+#else
+        QFile::remove(tasks.at(i).thumbnailPath);
+        const bool renamed = file->rename(tasks.at(i).thumbnailPath);
+#endif
+
+        if (!renamed)
+        {
+            tasks[i].errorString = QStringLiteral("Can not save image to ") + tasks.at(i).thumbnailPath;
+            file->remove();
+        }
+
+        delete file;
+    }
+
+#ifdef Q_OS_UNIX
+    // make the renames durable
+    for (const QString &dirPath : directories)
+    {
+        const int fd = ::open(QFile::encodeName(dirPath).constData(), O_RDONLY);
+
+        if (fd >= 0)
+        {
+            ::fsync(fd);
+            ::close(fd);
+        }
+    }
+#endif
+
+    // the skipped duplicates share the result of the written task
+    for (int i = 0; i < tasks.size(); ++i)
+    {
+        const int last = lastTasks.value(tasks.at(i).thumbnailPath);
+
+        if (last != i)
+        {
+            tasks[i].errorString = tasks.at(last).errorString;
+        }
+    }
+}
+
+void DThumbnailProviderPrivate::setErrorString(const QString &error)
+{
+    QMutexLocker locker(&errorLock);
+
+    errorString = error;
+}
+
+QString DThumbnailProviderPrivate::finishThumbnail(const WriteTask &task)
+{
+    Q_Q(DThumbnailProvider);
+
+    setErrorString(task.errorString);
+
+    if (task.errorString.isEmpty())
+    {
+        insertCache(task.sourceFilePath, task.size, task.thumbnailPath, task.sourceMTime, task.image);
+
+        Q_EMIT q->createThumbnailFinished(task.sourceFilePath, task.thumbnailPath);
+        Q_EMIT q->thumbnailChanged(task.sourceFilePath, task.thumbnailPath);
+
+        return task.thumbnailPath;
+    }
+
+    // fail
+    Q_EMIT q->createThumbnailFailed(task.sourceFilePath);
+
+    return QString();
+}
+
+void DThumbnailProviderPrivate::enqueueWrite(WriteTask &&task)
+{
+    QMutexLocker locker(&writeMutex);
+
+    if (!writer)
+    {
+        writer = new DThumbnailWriter(this);
+        writer->start();
+    }
+
+    // do not let decoded images pile up in memory when the disk is slower than the workers
+    while (writeQueue.size() >= 64)
+    {
+        writeCondition.wait(&writeMutex);
+    }
+
+    writeQueue.append(std::move(task));
+    writeCondition.wakeAll();
+}
+
+void DThumbnailProviderPrivate::writerLoop()
+{
+    Q_FOREVER
+    {
+        QList<WriteTask> tasks;
+
+        {
+            QMutexLocker locker(&writeMutex);
+
+            while (writeQueue.isEmpty())
+            {
+                // the queue is drained before exiting
+                if (!running)
+                {
+                    return;
+                }
+
+                writeCondition.wait(&writeMutex);
+            }
+
+            tasks.reserve(writeQueue.size());
+
+            while (!writeQueue.isEmpty())
+            {
+                tasks.append(writeQueue.dequeue());
+            }
+
+            writeCondition.wakeAll();
+        }
+
+        writeThumbnails(tasks);
+
+        for (const WriteTask &task : tasks)
+        {
+            const QString &thumbnail = finishThumbnail(task);
+
+            if (task.callback)
+            {
+                task.callback(thumbnail);
+            }
+        }
+    }
+}
+
+void DThumbnailProviderPrivate::startGarbageCollection(bool force)
+{
+    QMutexLocker locker(&collectMutex);
+    Q_UNUSED(locker)
+
+    if (!collector)
+    {
+        collector = new DThumbnailCollector(this);
+    }
+
+    if (collector->isRunning())
+    {
+        return;
+    }
+
+    // automatic collections run at most once an hour
+    if (!force && !lastCollectTimer.hasExpired(3600 * 1000))
+    {
+        return;
+    }
+
+    lastCollectTimer.start();
+    collector->start(QThread::IdlePriority);
+}
+
+void DThumbnailProviderPrivate::collectGarbage()
+{
+    Q_Q(DThumbnailProvider);
+
+#ifdef Q_OS_LINUX
+    // IOPRIO_WHO_PROCESS with pid 0 targets the calling thread, IOPRIO_CLASS_IDLE is 3
+    ::syscall(SYS_ioprio_set, 1, 0, 3 << 13);
+#endif
+
+    qint64 byteLimit;
+    int entryLimit;
+
+    {
+        QMutexLocker locker(&collectMutex);
+        byteLimit = diskCacheLimit;
+        entryLimit = diskCacheEntryLimit;
+    }
+
+    struct Entry
+    {
+        QString filePath;
+        qint64 size;
+        QDateTime lastRead;
+    };
+
+    QList<Entry> entries;
+    qint64 totalBytes = 0;
+    qint64 removedBytes = 0;
+    int removedCount = 0;
+    const QDateTime &now = QDateTime::currentDateTime();
+
+    const QStringList dirPaths {sizeToFilePath(DThumbnailProvider::Small), sizeToFilePath(DThumbnailProvider::Normal),
+                                sizeToFilePath(DThumbnailProvider::Large), failPath()};
+
+    for (const QString &dirPath : dirPaths)
+    {
+        QDirIterator iterator(dirPath, QDir::Files | QDir::Hidden | QDir::NoSymLinks, QDirIterator::Subdirectories);
+
+        while (iterator.hasNext())
+        {
+            if (!running)
+            {
+                return;
+            }
+
+            iterator.next();
+
+            const QFileInfo &info = iterator.fileInfo();
+            bool orphan = false;
+
+            if (info.fileName().contains(QStringLiteral(".part-")))
+            {
+                // leftover of an interrupted write
+                orphan = info.lastModified().secsTo(now) > 3600;
+
+                if (!orphan)
+                {
+                    continue;
+                }
+            }
+            else
+            {
+                QByteArray url;
+
+                if (readThumbnailText(info.absoluteFilePath(), QT_STRINGIFY(Thumb::URL), &url))
+                {
+                    const QUrl &sourceUrl = QUrl::fromEncoded(url);
+
+                    orphan = sourceUrl.isLocalFile() && !QFile::exists(sourceUrl.toLocalFile());
+                }
+            }
+
+            if (orphan)
+            {
+                if (QFile::remove(info.absoluteFilePath()))
+                {
+                    removedBytes += info.size();
+                    ++removedCount;
+                }
+
+                continue;
+            }
+
+            entries << Entry {info.absoluteFilePath(), info.size(), info.lastRead()};
+            totalBytes += info.size();
+        }
+    }
+
+    // least recently read first
+    std::sort(entries.begin(), entries.end(), [] (const Entry &e1, const Entry &e2) {
+        return e1.lastRead < e2.lastRead;
+    });
+
+    int remainingCount = entries.size();
+
+    for (const Entry &entry : entries)
+    {
+        if ((byteLimit <= 0 || totalBytes <= byteLimit) && (entryLimit <= 0 || remainingCount <= entryLimit))
+        {
+            break;
+        }
+
+        if (!running)
+        {
+            return;
+        }
+
+        if (QFile::remove(entry.filePath))
+        {
+            totalBytes -= entry.size;
+            --remainingCount;
+            removedBytes += entry.size;
+            ++removedCount;
+        }
+    }
+
+    Q_EMIT q->garbageCollected(removedCount, removedBytes, remainingCount, totalBytes);
+}
+
+QString DThumbnailProviderPrivate::thumbnailPath() const
+{
+    QMutexLocker locker(&cacheDirectoryLock);
+
+    if (cacheDirectory.isEmpty())
+    {
+        return THUMBNAIL_PATH;
+    }
+
+    return cacheDirectory;
+}
+
+QString DThumbnailProviderPrivate::failPath() const
+{
+    return thumbnailPath() + "/fail";
+}
+
+bool DThumbnailProviderPrivate::isThumbnailPath(const QString &absolutePath) const
+{
+    const QString &path = thumbnailPath();
+
+    return absolutePath == path + "/small"
+            || absolutePath == path + "/normal"
+            || absolutePath == path + "/large"
+            || absolutePath == path + "/fail";
+}
+
+QString DThumbnailProviderPrivate::sizeToFilePath(DThumbnailProvider::Size size) const
+{
+    switch (size)
+    {
+    case DThumbnailProvider::Small:
+        return thumbnailPath() + "/small";
+    case DThumbnailProvider::Normal:
+        return thumbnailPath() + "/normal";
+    case DThumbnailProvider::Large:
+        return thumbnailPath() + "/large";
+    }
+
+    return QString();
+}
+
+// tries the cheapest way to get an image of at least the thumbnail size, in order:
+// the embedded Exif thumbnail, a decoder side downscale, a full decode
+bool DThumbnailProviderPrivate::readImage(QImageReader &reader, const QSize &imageSize, DThumbnailProvider::Size size, QImage *image)
+{
+    const bool needScale = imageSize.width() >= size || imageSize.height() >= size;
+    const QSize &scaledSize = imageSize.scaled(size, size, Qt::KeepAspectRatio);
+    QElapsedTimer timer;
+
+    if (needScale && reader.format() == "jpeg")
+    {
+        timer.start();
+
+        const QImage &exifImage = readExifThumbnail(reader.fileName());
+        // some cameras store a letterboxed thumbnail, it can not be used for other aspect ratios
+        const bool usable = !exifImage.isNull()
+                && qMax(exifImage.width(), exifImage.height()) >= size
+                && qAbs(qreal(exifImage.width()) / exifImage.height() - qreal(imageSize.width()) / imageSize.height()) < 0.02;
+
+        if (usable)
+        {
+            *image = exifImage.scaled(scaledSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        }
+
+        recordDecodeStage(DThumbnailProvider::EmbeddedThumbnailStage, timer.nsecsElapsed());
+
+        if (usable)
+        {
+            return true;
+        }
+    }
+
+    timer.start();
+
+    if (needScale && reader.supportsOption(QImageIOHandler::ScaledSize))
+    {
+        QSize decodeSize = scaledSize;
+
+        if (reader.format() == "jpeg")
+        {
+            // only ask for the libjpeg scale_denom step (1/2, 1/4, 1/8) at or above the
+            // thumbnail size, the jpeg handler then keeps its default quality and does
+            // not resize, the remainder is smooth scaled below
+            int denom = 8;
+
+            while (denom > 1 && ((imageSize.width() + denom - 1) / denom < scaledSize.width()
+                                 || (imageSize.height() + denom - 1) / denom < scaledSize.height()))
+            {
+                denom /= 2;
+            }
+
+            decodeSize = QSize((imageSize.width() + denom - 1) / denom, (imageSize.height() + denom - 1) / denom);
+        }
+
+        reader.setScaledSize(decodeSize);
+
+        bool ok = reader.read(image);
+
+        if (ok && image->size() != scaledSize)
+        {
+            *image = image->scaled(scaledSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        }
+
+        recordDecodeStage(DThumbnailProvider::ScaledDecodeStage, timer.nsecsElapsed());
+
+        if (ok)
+        {
+            return true;
+        }
+
+        // the reader can not be rewound, reopen the file and fall back to a full decode
+        reader.setFileName(reader.fileName());
+        reader.setScaledSize(QSize());
+        timer.start();
+    }
+
+    bool ok = reader.read(image);
+
+    if (ok && needScale)
+    {
+        *image = image->scaled(scaledSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    }
+
+    recordDecodeStage(DThumbnailProvider::FullDecodeStage, timer.nsecsElapsed());
+
+    return ok;
+}
+
+void DThumbnailProviderPrivate::recordDecodeStage(DThumbnailProvider::DecodeStage stage, qint64 nsecs)
+{
+    decodeStageTime[stage].fetchAndAddRelaxed(nsecs);
+    decodeStageCount[stage].fetchAndAddRelaxed(1);
+}
+
+class DFileThumbnailProviderPrivate : public DThumbnailProvider {};
+Q_GLOBAL_STATIC(DFileThumbnailProviderPrivate, ftpGlobal)
+
+DThumbnailProvider *DThumbnailProvider::instance()
+{
+    return ftpGlobal;
+}
+
+bool DThumbnailProvider::hasThumbnail(const QFileInfo &info) const
+{
+    Q_D(const DThumbnailProvider);
+
+    if (!info.isReadable() || !info.isFile())
+    {
+        return false;
+    }
+
+    qint64 fileSize = info.size();
+
+    if (fileSize <= 0)
+    {
+        return false;
+    }
+
+    const QMimeType &mime = d->mimeTypeForFile(info);
+
+    if (fileSize > sizeLimit(mime))
+    {
+        return false;
+    }
+
+    return hasThumbnail(mime);
+}
+
+bool DThumbnailProvider::hasThumbnail(const QMimeType &mimeType) const
+{
+    return DThumbnailProviderPrivate::hasThumbnailMimeHash().contains(mimeType.name());
+}
+
+/*!
+ * \brief DThumbnailProvider::hasThumbnail checks a batch of files, suitable for directory pre-scans.
+ * \return whether each file of \a infos has a thumbnail, in the same order.
+ */
+QList<bool> DThumbnailProvider::hasThumbnail(const QList<QFileInfo> &infos) const
+{
+    QList<bool> list;
 
-        DThumbnailProviderPrivate::hasThumbnailMimeHash.reserve(mimeTypes.size());
+    list.reserve(infos.size());
 
-        for (const QByteArray &t : mimeTypes)
-        {
-            DThumbnailProviderPrivate::hasThumbnailMimeHash.insert(QString::fromLocal8Bit(t));
-        }
+    for (const QFileInfo &info : infos)
+    {
+        list << hasThumbnail(info);
     }
 
-    return DThumbnailProviderPrivate::hasThumbnailMimeHash.contains(mime);
+    return list;
 }
 
 QString DThumbnailProvider::thumbnailFilePath(const QFileInfo &info, Size size) const
@@ -178,194 +1428,455 @@ QString DThumbnailProvider::thumbnailFilePath(const QFileInfo &info, Size size)
     const QString &absolutePath = info.absolutePath();
     const QString &absoluteFilePath = info.absoluteFilePath();
 
-    if (absolutePath == d->sizeToFilePath(Small)
-            || absolutePath == d->sizeToFilePath(Normal)
-            || absolutePath == d->sizeToFilePath(Large)
-            || absolutePath == THUMBNAIL_FAIL_PATH)
+    if (d->isThumbnailPath(absolutePath))
     {
         return absoluteFilePath;
     }
 
+    const qint64 sourceMTime = info.lastModified().toTime_t();
+
+    {
+        QMutexLocker locker(&d->cacheLock);
+        const DThumbnailProviderPrivate::ThumbnailCacheEntry *entry = d->thumbnailCache.object(qMakePair(absoluteFilePath, static_cast<int>(size)));
+
+        // a stat of both files is enough to trust an already validated thumbnail
+        if (entry && entry->sourceMTime == sourceMTime
+                && QFileInfo(entry->thumbnailPath).lastModified() == entry->thumbnailMTime)
+        {
+            return entry->thumbnailPath;
+        }
+    }
+
     const QString thumbnailName = dataToMd5Hex(QUrl::fromLocalFile(absoluteFilePath).toString(QUrl::FullyEncoded).toLocal8Bit()) + FORMAT;
     QString thumbnail = d->sizeToFilePath(size) + QDir::separator() + thumbnailName;
 
     if (!QFile::exists(thumbnail))
     {
+        d->removeCache(absoluteFilePath);
+
         return QString();
     }
 
-    QImage image(thumbnail);
+    qint64 thumbnailMTime = 0;
 
-    if (image.text(QT_STRINGIFY(Thumb::MTime)).toInt() != (int)info.lastModified().toTime_t())
+    if (!readThumbnailMTime(thumbnail, &thumbnailMTime) || thumbnailMTime != sourceMTime)
     {
         QFile::remove(thumbnail);
+        d->removeCache(absoluteFilePath);
 
         Q_EMIT thumbnailChanged(absoluteFilePath, QString());
 
         return QString();
     }
 
+    d->insertCache(absoluteFilePath, size, thumbnail, sourceMTime);
+
     return thumbnail;
 }
 
-QString DThumbnailProvider::createThumbnail(const QFileInfo &info, DThumbnailProvider::Size size)
+/*!
+ * \brief DThumbnailProvider::thumbnailImage returns the decoded thumbnail of \a info,
+ * the image is kept in a memory cache bounded by cacheLimit().
+ */
+QImage DThumbnailProvider::thumbnailImage(const QFileInfo &info, Size size) const
 {
-    Q_D(DThumbnailProvider);
+    Q_D(const DThumbnailProvider);
 
-    d->errorString.clear();
+    const QString &thumbnail = thumbnailFilePath(info, size);
+
+    if (thumbnail.isEmpty())
+    {
+        return QImage();
+    }
 
-    const QString &absolutePath = info.absolutePath();
     const QString &absoluteFilePath = info.absoluteFilePath();
 
-    if (absolutePath == d->sizeToFilePath(Small)
-            || absolutePath == d->sizeToFilePath(Normal)
-            || absolutePath == d->sizeToFilePath(Large)
-            || absolutePath == THUMBNAIL_FAIL_PATH)
     {
-        return absoluteFilePath;
+        QMutexLocker locker(&d->cacheLock);
+        const DThumbnailProviderPrivate::ThumbnailCacheEntry *entry = d->thumbnailCache.object(qMakePair(absoluteFilePath, static_cast<int>(size)));
+
+        if (entry && entry->thumbnailPath == thumbnail && !entry->image.isNull())
+        {
+            return entry->image;
+        }
     }
 
-    if (!hasThumbnail(info))
+    const QImage image(thumbnail);
+
+    if (!image.isNull())
     {
-        d->errorString = QStringLiteral("This file has not support thumbnail: ") + absoluteFilePath;
+        d->insertCache(absoluteFilePath, size, thumbnail, info.lastModified().toTime_t(), image);
+    }
 
-        //!Warnning: Do not store thumbnails to the fail path
-        return QString();
+    return image;
+}
+
+QString DThumbnailProvider::createThumbnail(const QFileInfo &info, DThumbnailProvider::Size size)
+{
+    Q_D(DThumbnailProvider);
+
+    DThumbnailProviderPrivate::WriteTask task;
+    QString thumbnail;
+
+    if (d->prepareThumbnail(info, size, &task, &thumbnail))
+    {
+        QList<DThumbnailProviderPrivate::WriteTask> tasks {task};
+
+        d->writeThumbnails(tasks);
+
+        return d->finishThumbnail(tasks.first());
     }
 
-    const QString fileUrl = QUrl::fromLocalFile(absoluteFilePath).toString(QUrl::FullyEncoded);
-    const QString thumbnailName = dataToMd5Hex(fileUrl.toLocal8Bit()) + FORMAT;
+    d->setErrorString(task.errorString);
 
-    // the file is in fail path
-    QString thumbnail = THUMBNAIL_FAIL_PATH + QDir::separator() + thumbnailName;
+    return thumbnail;
+}
+
+void DThumbnailProvider::appendToProduceQueue(const QFileInfo &info, DThumbnailProvider::Size size, DThumbnailProvider::CallBack callback)
+{
+    appendToProduceQueue(info, size, NormalPriority, callback);
+}
+
+/*!
+ * \brief DThumbnailProvider::appendToProduceQueue queues \a info for production with \a priority.
+ * Files passed to setViewportFiles() keep the priority assigned there.
+ */
+void DThumbnailProvider::appendToProduceQueue(const QFileInfo &info, DThumbnailProvider::Size size, Priority priority, DThumbnailProvider::CallBack callback)
+{
+    Q_D(DThumbnailProvider);
+
+    DThumbnailProviderPrivate::ProduceTask task(new DThumbnailProviderPrivate::ProduceInfo());
+
+    task->fileInfo = info;
+    task->size = size;
+    task->callback = callback;
 
-    if (QFile::exists(thumbnail))
     {
-        QImage image(thumbnail);
+        QMutexLocker locker(&d->taskLock);
+        const QString &filePath = info.absoluteFilePath();
 
-        if (image.text(QT_STRINGIFY(Thumb::MTime)).toInt() != (int)info.lastModified().toTime_t())
-        {
-            QFile::remove(thumbnail);
-        }
-        else
-        {
-            return QString();
-        }
-    }// end
+        task->requestedPriority = priority;
+        task->priority = d->viewportPriorities.value(filePath, priority);
+        d->pendingTasks[filePath].append(task);
+        d->enqueue(task);
+    }
 
-    QScopedPointer<QImage> image(new QImage(QSize(size, size), QImage::Format_ARGB32_Premultiplied));
-    QImageReader reader(absoluteFilePath);
+    d->startWorkers();
+    d->startGarbageCollection(false);
+}
 
-    if (!reader.canRead())
+void DThumbnailProvider::removeInProduceQueue(const QFileInfo &info, DThumbnailProvider::Size size)
+{
+    Q_D(DThumbnailProvider);
+
+    QMutexLocker locker(&d->taskLock);
+    Q_UNUSED(locker)
+
+    auto it = d->pendingTasks.find(info.absoluteFilePath());
+
+    if (it == d->pendingTasks.end())
     {
-        reader.setFormat(d->mimeDatabase.mimeTypeForFile(info).name().toLocal8Bit());
+        return;
+    }
 
-        if (!reader.canRead())
+    QList<DThumbnailProviderPrivate::ProduceTask> &tasks = it.value();
+
+    for (int i = tasks.size() - 1; i >= 0; --i)
+    {
+        if (tasks.at(i)->size == size)
         {
-            d->errorString = reader.errorString();
+            tasks.takeAt(i)->discarded = true;
         }
     }
 
-    if (d->errorString.isEmpty())
+    if (tasks.isEmpty())
     {
-        const QSize &imageSize = reader.size();
+        d->pendingTasks.erase(it);
+    }
+}
 
-        if (imageSize.isValid())
-        {
-            if (imageSize.width() >= size || imageSize.height() >= size)
-            {
-                reader.setScaledSize(reader.size().scaled(size, size, Qt::KeepAspectRatio));
-            }
+/*!
+ * \brief DThumbnailProvider::reprioritize moves the queued tasks of \a filePaths to \a priority.
+ */
+void DThumbnailProvider::reprioritize(const QStringList &filePaths, Priority priority)
+{
+    Q_D(DThumbnailProvider);
 
-            if (!reader.read(image.data()))
-            {
-                d->errorString = reader.errorString();
-            }
+    QMutexLocker locker(&d->taskLock);
+    Q_UNUSED(locker)
+
+    for (const QString &filePath : filePaths)
+    {
+        auto it = d->pendingTasks.find(filePath);
+
+        if (it == d->pendingTasks.end())
+        {
+            continue;
         }
-        else
+
+        for (DThumbnailProviderPrivate::ProduceTask &task : it.value())
         {
-            d->errorString = "Fail to read image file attribute data:" + info.absoluteFilePath();
+            task->requestedPriority = priority;
+            d->requeue(task, priority);
         }
     }
+}
 
-    // successful
-    if (d->errorString.isEmpty())
+/*!
+ * \brief DThumbnailProvider::setViewportFiles produces the thumbnails of \a visibleFiles first
+ * and \a prefetchFiles next, files of the previous viewport go back to the priority they were queued with.
+ * Views should call it whenever they scroll.
+ */
+void DThumbnailProvider::setViewportFiles(const QStringList &visibleFiles, const QStringList &prefetchFiles)
+{
+    Q_D(DThumbnailProvider);
+
+    QHash<QString, Priority> priorities;
+
+    priorities.reserve(visibleFiles.size() + prefetchFiles.size());
+
+    for (const QString &filePath : prefetchFiles)
     {
-        thumbnail = d->sizeToFilePath(size) + QDir::separator() + thumbnailName;
+        priorities.insert(filePath, PrefetchPriority);
     }
-    else
+
+    for (const QString &filePath : visibleFiles)
     {
-        //fail
-        image.reset(new QImage(1, 1, QImage::Format_Mono));
+        priorities.insert(filePath, VisiblePriority);
     }
 
-    image->setText(QT_STRINGIFY(Thumb::URL), fileUrl);
-    image->setText(QT_STRINGIFY(Thumb::MTime), QString::number(info.lastModified().toTime_t()));
-
-    // create path
-    QFileInfo(thumbnail).absoluteDir().mkpath(".");
+    QMutexLocker locker(&d->taskLock);
+    Q_UNUSED(locker)
 
-    if (!image->save(thumbnail, Q_NULLPTR, 80))
+    for (auto it = d->viewportPriorities.constBegin(); it != d->viewportPriorities.constEnd(); ++it)
     {
-        d->errorString = QStringLiteral("Can not save image to ") + thumbnail;
+        if (!priorities.contains(it.key()))
+        {
+            d->restorePriority(it.key());
+        }
     }
 
-    if (d->errorString.isEmpty())
+    for (auto it = priorities.constBegin(); it != priorities.constEnd(); ++it)
     {
-        Q_EMIT createThumbnailFinished(absoluteFilePath, thumbnail);
-        Q_EMIT thumbnailChanged(absoluteFilePath, thumbnail);
-
-        return thumbnail;
+        d->requeue(it.key(), it.value());
     }
 
-    // fail
-    Q_EMIT createThumbnailFailed(absoluteFilePath);
+    d->viewportPriorities = priorities;
+}
 
-    return QString();
+QString DThumbnailProvider::errorString() const
+{
+    Q_D(const DThumbnailProvider);
+    QMutexLocker locker(&d->errorLock);
+
+    return d->errorString;
 }
 
-void DThumbnailProvider::appendToProduceQueue(const QFileInfo &info, DThumbnailProvider::Size size, DThumbnailProvider::CallBack callback)
+/*!
+ * \brief DThumbnailProvider::decodeStageTime
+ * \return the total time in nanoseconds spent in \a stage by createThumbnail().
+ */
+qint64 DThumbnailProvider::decodeStageTime(DecodeStage stage) const
+{
+    Q_D(const DThumbnailProvider);
+
+    return d->decodeStageTime[stage].load();
+}
+
+/*!
+ * \brief DThumbnailProvider::decodeStageCount
+ * \return how many times createThumbnail() ran \a stage.
+ */
+int DThumbnailProvider::decodeStageCount(DecodeStage stage) const
 {
-    DThumbnailProviderPrivate::ProduceInfo produceInfo;
+    Q_D(const DThumbnailProvider);
 
-    produceInfo.fileInfo = info;
-    produceInfo.size = size;
-    produceInfo.callback = callback;
+    return d->decodeStageCount[stage].load();
+}
 
+void DThumbnailProvider::resetDecodeStageTimings()
+{
     Q_D(DThumbnailProvider);
 
-    if (isRunning())
-    {
-        QWriteLocker locker(&d->dataReadWriteLock);
-        d->produceQueue.append(std::move(produceInfo));
-        locker.unlock();
-        d->waitCondition.wakeAll();
-    }
-    else
+    for (int i = EmbeddedThumbnailStage; i <= FullDecodeStage; ++i)
     {
-        d->produceQueue.append(std::move(produceInfo));
-        start();
+        d->decodeStageTime[i].store(0);
+        d->decodeStageCount[i].store(0);
     }
 }
 
-void DThumbnailProvider::removeInProduceQueue(const QFileInfo &info, DThumbnailProvider::Size size)
+qint64 DThumbnailProvider::cacheLimit() const
+{
+    Q_D(const DThumbnailProvider);
+
+    QMutexLocker locker(&d->cacheLock);
+    Q_UNUSED(locker)
+
+    return qint64(d->thumbnailCache.maxCost()) * 1024;
+}
+
+/*!
+ * \brief DThumbnailProvider::setCacheLimit sets the memory used by decoded thumbnails
+ * of thumbnailImage() to at most \a bytes, it defaults to 64MB.
+ */
+void DThumbnailProvider::setCacheLimit(qint64 bytes)
 {
     Q_D(DThumbnailProvider);
 
-    if (isRunning())
+    QMutexLocker locker(&d->cacheLock);
+    Q_UNUSED(locker)
+
+    d->thumbnailCache.setMaxCost(static_cast<int>(qBound<qint64>(1, bytes / 1024, INT_MAX)));
+}
+
+qint64 DThumbnailProvider::diskCacheLimit() const
+{
+    Q_D(const DThumbnailProvider);
+
+    return d->diskCacheLimit;
+}
+
+/*!
+ * \brief DThumbnailProvider::setDiskCacheLimit sets the size of the thumbnail cache directories
+ * kept by the garbage collector to \a bytes, it defaults to 1GB. 0 means no limit.
+ */
+void DThumbnailProvider::setDiskCacheLimit(qint64 bytes)
+{
+    Q_D(DThumbnailProvider);
+
+    QMutexLocker locker(&d->collectMutex);
+    Q_UNUSED(locker)
+
+    d->diskCacheLimit = bytes;
+}
+
+int DThumbnailProvider::diskCacheEntryLimit() const
+{
+    Q_D(const DThumbnailProvider);
+
+    return d->diskCacheEntryLimit;
+}
+
+/*!
+ * \brief DThumbnailProvider::setDiskCacheEntryLimit sets the number of thumbnails
+ * kept by the garbage collector to \a count, it defaults to 0 which means no limit.
+ */
+void DThumbnailProvider::setDiskCacheEntryLimit(int count)
+{
+    Q_D(DThumbnailProvider);
+
+    QMutexLocker locker(&d->collectMutex);
+    Q_UNUSED(locker)
+
+    d->diskCacheEntryLimit = count;
+}
+
+/*!
+ * \brief DThumbnailProvider::collectGarbage starts a garbage collection of the thumbnail cache
+ * in the background. Thumbnails of removed local files are deleted, then the least recently
+ * read ones until the cache fits diskCacheLimit() and diskCacheEntryLimit().
+ * A collection also runs automatically at most once an hour while producing thumbnails.
+ * \sa garbageCollected
+ */
+void DThumbnailProvider::collectGarbage()
+{
+    Q_D(DThumbnailProvider);
+
+    d->startGarbageCollection(true);
+}
+
+QString DThumbnailProvider::cacheDirectory() const
+{
+    Q_D(const DThumbnailProvider);
+    QMutexLocker locker(&d->cacheDirectoryLock);
+
+    return d->cacheDirectory;
+}
+
+/*!
+ * \brief DThumbnailProvider::setCacheDirectory stores the thumbnails in \a path instead of
+ * the shared freedesktop cache, with the same small, normal, large and fail layout.
+ * An empty path, the default, selects the freedesktop cache again. Thumbnails already in
+ * the memory cache are dropped.
+ * \sa setSaveQuality
+ */
+void DThumbnailProvider::setCacheDirectory(const QString &path)
+{
+    Q_D(DThumbnailProvider);
+
+    const QString &directory = path.isEmpty() ? QString() : QDir(path).absolutePath();
+
     {
-        QWriteLocker locker(&d->dataReadWriteLock);
-        Q_UNUSED(locker)
+        QMutexLocker locker(&d->cacheDirectoryLock);
+
+        if (d->cacheDirectory == directory)
+        {
+            return;
+        }
+
+        d->cacheDirectory = directory;
     }
 
-    d->discardedProduceInfos.insert(qMakePair(info.absoluteFilePath(), size));
+    QMutexLocker locker(&d->cacheLock);
+    Q_UNUSED(locker)
+
+    d->thumbnailCache.clear();
 }
 
-QString DThumbnailProvider::errorString() const
+int DThumbnailProvider::saveQuality() const
 {
     Q_D(const DThumbnailProvider);
 
-    return d->errorString;
+    return d->saveQuality.loadAcquire();
+}
+
+/*!
+ * \brief DThumbnailProvider::setSaveQuality sets the PNG quality thumbnails of a private cache
+ * are saved with, it defaults to 80. A higher quality selects a lower zlib compression level,
+ * which is faster to write but bigger on disk. Thumbnails in the shared freedesktop cache are
+ * always saved with the default quality, so this only takes effect after setCacheDirectory().
+ */
+void DThumbnailProvider::setSaveQuality(int quality)
+{
+    Q_D(DThumbnailProvider);
+
+    d->saveQuality.storeRelease(qBound(0, quality, 100));
+}
+
+int DThumbnailProvider::workerCount() const
+{
+    Q_D(const DThumbnailProvider);
+
+    return d->workerCount;
+}
+
+/*!
+ * \brief DThumbnailProvider::setWorkerCount sets the number of threads producing thumbnails
+ * from the produce queue, it defaults to QThread::idealThreadCount().
+ * Tasks queued on a retired worker are stolen by the remaining ones.
+ */
+void DThumbnailProvider::setWorkerCount(int count)
+{
+    Q_D(DThumbnailProvider);
+
+    count = qMax(1, count);
+
+    if (d->workerCount == count)
+    {
+        return;
+    }
+
+    {
+        QMutexLocker locker(&d->waitMutex);
+        QWriteLocker poolLocker(&d->poolLock);
+        d->workerCount = count;
+        d->waitCondition.wakeAll();
+    }
+
+    if (isRunning())
+    {
+        d->startWorkers();
+    }
 }
 
 qint64 DThumbnailProvider::defaultSizeLimit() const
@@ -407,48 +1918,45 @@ DThumbnailProvider::~DThumbnailProvider()
 {
     Q_D(DThumbnailProvider);
 
-    d->running = false;
-    d->waitCondition.wakeAll();
-    wait();
-}
+    {
+        QMutexLocker locker(&d->waitMutex);
+        d->running = false;
+        d->waitCondition.wakeAll();
+    }
 
-void DThumbnailProvider::run()
-{
-    Q_D(DThumbnailProvider);
+    wait();
 
-    Q_FOREVER
+    for (DThumbnailWorker *worker : d->workers)
     {
-        QWriteLocker locker(&d->dataReadWriteLock);
-
-        if (d->produceQueue.isEmpty())
-        {
-            d->waitCondition.wait(&d->dataReadWriteLock);
-        }
+        worker->wait();
+    }
 
-        if (!d->running)
-        {
-            return;
-        }
+    {
+        QMutexLocker locker(&d->writeMutex);
+        d->writeCondition.wakeAll();
+    }
 
-        const DThumbnailProviderPrivate::ProduceInfo &task = d->produceQueue.dequeue();
-        const QPair<QString, DThumbnailProvider::Size> &tmpKey = qMakePair(task.fileInfo.absoluteFilePath(), task.size);
+    if (d->writer)
+    {
+        d->writer->wait();
+        delete d->writer;
+    }
 
-        if (d->discardedProduceInfos.contains(tmpKey))
-        {
-            d->discardedProduceInfos.remove(tmpKey);
-            locker.unlock();
-            continue;
-        }
+    if (d->collector)
+    {
+        d->collector->wait();
+        delete d->collector;
+    }
 
-        locker.unlock();
+    qDeleteAll(d->workers);
+    qDeleteAll(d->produceQueues);
+}
 
-        const QString &thumbnail = createThumbnail(task.fileInfo, task.size);
+void DThumbnailProvider::run()
+{
+    Q_D(DThumbnailProvider);
 
-        if (task.callback)
-        {
-            task.callback(thumbnail);
-        }
-    }
+    d->workerLoop(0);
 }
 
 DWIDGET_END_NAMESPACE
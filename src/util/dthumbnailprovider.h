@@ -20,6 +20,7 @@
 
 #include <QThread>
 #include <QFileInfo>
+#include <QStringList>
 
 #include "dtkwidget_global.h"
 #include "dobject.h"
@@ -28,6 +29,7 @@
 
 QT_BEGIN_NAMESPACE
 class QMimeType;
+class QImage;
 QT_END_NAMESPACE
 
 DWIDGET_BEGIN_NAMESPACE
@@ -44,20 +46,60 @@ public:
         Large = 256,
     };
 
+    enum Priority {
+        LowPriority,
+        NormalPriority,
+        PrefetchPriority,
+        VisiblePriority
+    };
+
+    enum DecodeStage {
+        EmbeddedThumbnailStage,
+        ScaledDecodeStage,
+        FullDecodeStage
+    };
+
     static DThumbnailProvider *instance();
 
     bool hasThumbnail(const QFileInfo &info) const;
     bool hasThumbnail(const QMimeType &mimeType) const;
+    QList<bool> hasThumbnail(const QList<QFileInfo> &infos) const;
 
     QString thumbnailFilePath(const QFileInfo &info, Size size) const;
+    QImage thumbnailImage(const QFileInfo &info, Size size) const;
 
     QString createThumbnail(const QFileInfo &info, Size size);
     typedef std::function<void(const QString &)> CallBack;
     void appendToProduceQueue(const QFileInfo &info, Size size, CallBack callback = 0);
+    void appendToProduceQueue(const QFileInfo &info, Size size, Priority priority, CallBack callback = 0);
     void removeInProduceQueue(const QFileInfo &info, Size size);
+    void reprioritize(const QStringList &filePaths, Priority priority);
+    void setViewportFiles(const QStringList &visibleFiles, const QStringList &prefetchFiles = QStringList());
 
     QString errorString() const;
 
+    qint64 decodeStageTime(DecodeStage stage) const;
+    int decodeStageCount(DecodeStage stage) const;
+    void resetDecodeStageTimings();
+
+    qint64 cacheLimit() const;
+    void setCacheLimit(qint64 bytes);
+
+    qint64 diskCacheLimit() const;
+    void setDiskCacheLimit(qint64 bytes);
+    int diskCacheEntryLimit() const;
+    void setDiskCacheEntryLimit(int count);
+    void collectGarbage();
+
+    QString cacheDirectory() const;
+    void setCacheDirectory(const QString &path);
+
+    int saveQuality() const;
+    void setSaveQuality(int quality);
+
+    int workerCount() const;
+    void setWorkerCount(int count);
+
     qint64 defaultSizeLimit() const;
     void setDefaultSizeLimit(qint64 size);
 
@@ -68,6 +110,7 @@ Q_SIGNALS:
     void thumbnailChanged(const QString &sourceFilePath, const QString &thumbnailPath) const;
     void createThumbnailFinished(const QString &sourceFilePath, const QString &thumbnailPath) const;
     void createThumbnailFailed(const QString &sourceFilePath) const;
+    void garbageCollected(int removedCount, qint64 removedBytes, int remainingCount, qint64 remainingBytes) const;
 
 protected:
     explicit DThumbnailProvider(QObject *parent = 0);
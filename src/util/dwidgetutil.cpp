@@ -16,6 +16,7 @@
  */
 
 #include "dwidgetutil.h"
+#include "private/dblurengine_p.h"
 
 #include <QPixmap>
 #include <QPainter>
@@ -24,11 +25,6 @@
 #include <QApplication>
 #include <QDesktopWidget>
 
-QT_BEGIN_NAMESPACE
-//extern Q_WIDGETS_EXPORT void qt_blurImage(QImage &blurImage, qreal radius, bool quality, int transposed = 0);
-extern Q_WIDGETS_EXPORT void qt_blurImage(QPainter *p, QImage &blurImage, qreal radius, bool quality, bool alphaOnly, int transposed = 0);
-QT_END_NAMESPACE
-
 DWIDGET_BEGIN_NAMESPACE
 
 QImage dropShadow(const QPixmap &px, qreal radius, const QColor &color)
@@ -47,18 +43,12 @@ QImage dropShadow(const QPixmap &px, qreal radius, const QColor &color)
     tmpPainter.end();
 
     // blur the alpha channel
-    QImage blurred(tmp.size(), QImage::Format_ARGB32_Premultiplied);
-    blurred.fill(0);
-    QPainter blurPainter(&blurred);
-    qt_blurImage(&blurPainter, tmp, radius, false, true);
-    blurPainter.end();
+    DBlurEngine::blur(tmp, radius, true, DBlurEngine::downsampleFactor(radius));
 
     if (color == QColor(Qt::black)) {
-        return blurred;
+        return tmp;
     }
 
-    tmp = blurred;
-
     // blacken the image...
     tmpPainter.begin(&tmp);
     tmpPainter.setCompositionMode(QPainter::CompositionMode_SourceIn);
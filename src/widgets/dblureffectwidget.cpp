@@ -18,6 +18,7 @@
 #include "dblureffectwidget.h"
 #include "private/dblureffectwidget_p.h"
 #include "dplatformwindowhandle.h"
+#include "private/dblurengine_p.h"
 
 #include <DWindowManagerHelper>
 #include <DGuiApplicationHelper>
@@ -26,6 +27,12 @@
 #include <QBackingStore>
 #include <QPaintEvent>
 #include <QDebug>
+#include <QTimer>
+#include <QPointer>
+#include <QtMath>
+#include <QApplication>
+
+#include <cstring>
 
 #include <qpa/qplatformbackingstore.h>
 #include <private/qwidget_p.h>
@@ -44,10 +51,7 @@
 #undef private
 
 #define MASK_COLOR_ALPHA_DEFAULT 204
-
-QT_BEGIN_NAMESPACE
-Q_WIDGETS_EXPORT void qt_blurImage(QPainter *p, QImage &blurImage, qreal radius, bool quality, bool alphaOnly, int transposed = 0);
-QT_END_NAMESPACE
+#define BLUR_TILE_SIZE 64
 
 DGUI_USE_NAMESPACE
 
@@ -56,6 +60,27 @@ DWIDGET_BEGIN_NAMESPACE
 QMultiHash<QWidget *, const DBlurEffectWidget *> DBlurEffectWidgetPrivate::blurEffectWidgetHash;
 QHash<const DBlurEffectWidget *, QWidget *> DBlurEffectWidgetPrivate::windowOfBlurEffectHash;
 
+// 最近一次提交给窗管的模糊区域，窗口的 native window 重建后需要重新提交
+struct WindowBlurArea
+{
+    // 窗口销毁后指针失效，其地址可能被新窗口复用
+    QPointer<QWidget> window;
+    WId winId = 0;
+    QList<QPainterPath> pathList;
+    QVector<DPlatformWindowHandle::WMBlurArea> areaList;
+
+    bool operator==(const WindowBlurArea &other) const
+    {
+        return winId == other.winId && pathList == other.pathList
+               && areaList.size() == other.areaList.size()
+               && memcmp(areaList.constData(), other.areaList.constData(),
+                         areaList.size() * sizeof(DPlatformWindowHandle::WMBlurArea)) == 0;
+    }
+};
+
+static QHash<const QWidget *, WindowBlurArea> submittedBlurAreaHash;
+static QList<QPointer<QWidget>> pendingBlurAreaWindows;
+
 DBlurEffectWidgetPrivate::DBlurEffectWidgetPrivate(DBlurEffectWidget *qq)
     : DObjectPrivate(qq)
 {
@@ -85,14 +110,14 @@ void DBlurEffectWidgetPrivate::addToBlurEffectWidgetHash()
 
     if (oldTopLevelWidget) {
         blurEffectWidgetHash.remove(oldTopLevelWidget, q);
-        updateWindowBlurArea(oldTopLevelWidget);
+        requestWindowBlurAreaUpdate(oldTopLevelWidget);
     }
 
     QWidget *topLevelWidget = q->topLevelWidget();
 
     blurEffectWidgetHash.insertMulti(topLevelWidget, q);
     windowOfBlurEffectHash[q] = topLevelWidget;
-    updateWindowBlurArea(topLevelWidget);
+    requestWindowBlurAreaUpdate(topLevelWidget);
 }
 
 void DBlurEffectWidgetPrivate::removeFromBlurEffectWidgetHash()
@@ -107,7 +132,7 @@ void DBlurEffectWidgetPrivate::removeFromBlurEffectWidgetHash()
 
     blurEffectWidgetHash.remove(topLevelWidget, q);
     windowOfBlurEffectHash.remove(q);
-    updateWindowBlurArea(topLevelWidget);
+    requestWindowBlurAreaUpdate(topLevelWidget);
 }
 
 bool DBlurEffectWidgetPrivate::updateWindowBlurArea()
@@ -119,6 +144,14 @@ bool DBlurEffectWidgetPrivate::updateWindowBlurArea()
     return topLevelWidget && updateWindowBlurArea(topLevelWidget);
 }
 
+void DBlurEffectWidgetPrivate::requestWindowBlurAreaUpdate()
+{
+    D_QC(DBlurEffectWidget);
+
+    if (QWidget *topLevelWidget = windowOfBlurEffectHash.value(q))
+        requestWindowBlurAreaUpdate(topLevelWidget);
+}
+
 void DBlurEffectWidgetPrivate::setMaskAlpha(const quint8 alpha) {
     maskAlpha = alpha;
 
@@ -134,6 +167,22 @@ quint8 DBlurEffectWidgetPrivate::getMaskColorAlpha() const
     return static_cast<quint8>(maskAlpha);
 }
 
+int DBlurEffectWidgetPrivate::downsampleFactor(DBlurEffectWidget::BlurQuality quality, qreal pixelRadius)
+{
+    switch (quality) {
+    case DBlurEffectWidget::HighQuality:
+        return 1;
+    case DBlurEffectWidget::HighPerformance:
+        return DBlurEngine::downsampleFactor(pixelRadius, true);
+    default:
+        // 大半径的模糊缩小到 1/4 后几乎看不出差别，较小的半径和 qt_blurImage 一样缩小到 1/2
+        if (pixelRadius >= 20)
+            return 4;
+
+        return DBlurEngine::downsampleFactor(pixelRadius);
+    }
+}
+
 QColor DBlurEffectWidgetPrivate::getMaskColor(const QColor &baseColor) const
 {
     QColor color = baseColor;
@@ -163,9 +212,216 @@ void DBlurEffectWidgetPrivate::resetSourceImage()
     if (customSourceImage || group)
         return;
 
+    // 模糊图块保留，重新获取源图像后按哈希判断哪些图块需要重新模糊
     sourceImage = QImage();
 }
 
+void DBlurEffectWidgetPrivate::updateSourceImage(const QPoint &pos, const QImage &image, const QRect &rect)
+{
+    if (image.format() != sourceImage.format() || image.depth() < 8) {
+        const QImage &area = image.copy(rect).convertToFormat(sourceImage.format());
+
+        if (area.depth() >= 8)
+            updateSourceImage(pos, area, area.rect());
+
+        return;
+    }
+
+    QRect source_rect = rect & image.rect();
+    QRect target_rect = source_rect.translated(pos - rect.topLeft()) & sourceImage.rect();
+    source_rect = target_rect.translated(rect.topLeft() - pos);
+
+    if (target_rect.isEmpty())
+        return;
+
+    const int bytes_per_pixel = image.depth() / 8;
+    const int line_bytes = target_rect.width() * bytes_per_pixel;
+    int first_changed_line = -1;
+    int last_changed_line = -1;
+
+    // 逐行比较，只复制并记录发生变化的行
+    for (int y = 0; y < target_rect.height(); ++y) {
+        const uchar *from = image.constScanLine(source_rect.y() + y) + source_rect.x() * bytes_per_pixel;
+        uchar *to = sourceImage.scanLine(target_rect.y() + y) + target_rect.x() * bytes_per_pixel;
+
+        if (memcmp(from, to, line_bytes) != 0) {
+            memcpy(to, from, line_bytes);
+
+            if (first_changed_line < 0)
+                first_changed_line = y;
+
+            last_changed_line = y;
+        }
+    }
+
+    if (first_changed_line >= 0) {
+        markBlurTilesDirty(QRect(target_rect.x(), target_rect.y() + first_changed_line,
+                                 target_rect.width(), last_changed_line - first_changed_line + 1));
+    }
+}
+
+int DBlurEffectWidgetPrivate::blurTileMargin() const
+{
+    // 三次盒式模糊的作用范围约为 1.5 倍半径
+    return qCeil(1.5 * radius) + 1;
+}
+
+QRect DBlurEffectWidgetPrivate::blurTileSourceRect(int index) const
+{
+    const int column = index % blurTileColumns;
+    const int row = index / blurTileColumns;
+    const int rows = blurTiles.size() / blurTileColumns;
+    const QSize source_size = blurTilesSize + QSize(2 * radius, 2 * radius);
+
+    // 源图像四周比控件多出 radius 的边距，边缘的图块包含这部分边距，所有图块正好覆盖整个源图像
+    const int left = column == 0 ? 0 : column * BLUR_TILE_SIZE + radius;
+    const int top = row == 0 ? 0 : row * BLUR_TILE_SIZE + radius;
+    const int right = column == blurTileColumns - 1 ? source_size.width() : (column + 1) * BLUR_TILE_SIZE + radius;
+    const int bottom = row == rows - 1 ? source_size.height() : (row + 1) * BLUR_TILE_SIZE + radius;
+
+    return QRect(left, top, right - left, bottom - top);
+}
+
+uint DBlurEffectWidgetPrivate::blurTileSourceHash(int index) const
+{
+    const QRect &rect = blurTileSourceRect(index) & sourceImage.rect();
+    const int bytes_per_pixel = sourceImage.depth() / 8;
+    uint hash = 0;
+
+    for (int y = rect.top(); y <= rect.bottom(); ++y) {
+        hash = qHashBits(sourceImage.constScanLine(y) + rect.x() * bytes_per_pixel, rect.width() * bytes_per_pixel, hash);
+    }
+
+    return hash;
+}
+
+void DBlurEffectWidgetPrivate::updateBlurTileSourceHashes()
+{
+    if (sourceImage.depth() < 8)
+        return;
+
+    for (int index = 0; index < blurTiles.size(); ++index) {
+        blurTiles[index].sourceHash = blurTileSourceHash(index);
+        blurTiles[index].sourceHashValid = true;
+    }
+}
+
+void DBlurEffectWidgetPrivate::markBlurTilesDirty(const QRect &sourceRect)
+{
+    if (blurTiles.isEmpty())
+        return;
+
+    const QRect &tiles_rect = QRect(QPoint(0, 0), blurTilesSize);
+
+    // 变化区域所在图块的哈希失效
+    const QRect &hash_rect = sourceRect.translated(-radius, -radius) & tiles_rect;
+
+    for (int y = hash_rect.top() / BLUR_TILE_SIZE; !hash_rect.isEmpty() && y <= hash_rect.bottom() / BLUR_TILE_SIZE; ++y) {
+        for (int x = hash_rect.left() / BLUR_TILE_SIZE; x <= hash_rect.right() / BLUR_TILE_SIZE; ++x) {
+            blurTiles[y * blurTileColumns + x].sourceHashValid = false;
+        }
+    }
+
+    // 图块的模糊结果取决于图块外扩模糊作用范围的源图像区域
+    const int margin = blurTileMargin();
+    const QRect &rect = sourceRect.translated(-radius, -radius).adjusted(-margin, -margin, margin, margin) & tiles_rect;
+
+    if (rect.isEmpty())
+        return;
+
+    for (int y = rect.top() / BLUR_TILE_SIZE; y <= rect.bottom() / BLUR_TILE_SIZE; ++y) {
+        for (int x = rect.left() / BLUR_TILE_SIZE; x <= rect.right() / BLUR_TILE_SIZE; ++x) {
+            ++blurTiles[y * blurTileColumns + x].generation;
+        }
+    }
+}
+
+void DBlurEffectWidgetPrivate::markChangedBlurTiles()
+{
+    if (blurTiles.isEmpty() || sourceImage.size() != blurTilesSize + QSize(2 * radius, 2 * radius) || sourceImage.depth() < 8)
+        return;
+
+    for (int index = 0; index < blurTiles.size(); ++index) {
+        const uint hash = blurTileSourceHash(index);
+
+        if (!blurTiles[index].sourceHashValid || blurTiles[index].sourceHash != hash)
+            markBlurTilesDirty(blurTileSourceRect(index));
+
+        blurTiles[index].sourceHash = hash;
+        blurTiles[index].sourceHashValid = true;
+    }
+}
+
+void DBlurEffectWidgetPrivate::paintBlurTiles(QPainter *pa, const QRegion &region)
+{
+    const QSize size = sourceImage.size() - QSize(2 * radius, 2 * radius);
+
+    if (size.isEmpty())
+        return;
+
+    // 半径乘以缩放比较大时模糊缩小后的图像，缩小倍数变化后所有图块都需要重新模糊
+    const int downsample = downsampleFactor(blurQuality, radius * q_func()->devicePixelRatioF());
+
+    if (blurTilesSize != size || blurTilesRadius != radius || blurTilesDownsample != downsample) {
+        blurTilesSize = size;
+        blurTilesRadius = radius;
+        blurTilesDownsample = downsample;
+        blurTileColumns = (size.width() + BLUR_TILE_SIZE - 1) / BLUR_TILE_SIZE;
+        blurTiles.clear();
+        blurTiles.resize(blurTileColumns * ((size.height() + BLUR_TILE_SIZE - 1) / BLUR_TILE_SIZE));
+        updateBlurTileSourceHashes();
+    }
+
+    const QRect &bounding_rect = region.boundingRect() & QRect(QPoint(0, 0), size);
+
+    if (bounding_rect.isEmpty())
+        return;
+
+    QVector<int> paint_tiles;
+    QRect dirty_rect;
+
+    for (int y = bounding_rect.top() / BLUR_TILE_SIZE; y <= bounding_rect.bottom() / BLUR_TILE_SIZE; ++y) {
+        for (int x = bounding_rect.left() / BLUR_TILE_SIZE; x <= bounding_rect.right() / BLUR_TILE_SIZE; ++x) {
+            const QRect tile_rect = QRect(x * BLUR_TILE_SIZE, y * BLUR_TILE_SIZE, BLUR_TILE_SIZE, BLUR_TILE_SIZE) & QRect(QPoint(0, 0), size);
+
+            if (!region.intersects(tile_rect))
+                continue;
+
+            const BlurTile &tile = blurTiles.at(y * blurTileColumns + x);
+
+            if (tile.image.isNull() || tile.blurredGeneration != tile.generation)
+                dirty_rect |= tile_rect;
+
+            paint_tiles << y * blurTileColumns + x;
+        }
+    }
+
+    // 所有需要更新的图块一起模糊一次，再切分到各个图块
+    if (!dirty_rect.isEmpty()) {
+        const int margin = blurTileMargin();
+        const QRect &blur_rect = dirty_rect.translated(radius, radius).adjusted(-margin, -margin, margin, margin) & sourceImage.rect();
+        QImage image = sourceImage.copy(blur_rect);
+        DBlurEngine::blur(image, radius, false, downsample);
+
+        for (int index : paint_tiles) {
+            BlurTile &tile = blurTiles[index];
+            const QRect tile_rect = QRect((index % blurTileColumns) * BLUR_TILE_SIZE, (index / blurTileColumns) * BLUR_TILE_SIZE,
+                                          BLUR_TILE_SIZE, BLUR_TILE_SIZE) & QRect(QPoint(0, 0), size);
+
+            if (dirty_rect.contains(tile_rect) && (tile.image.isNull() || tile.blurredGeneration != tile.generation)) {
+                tile.image = image.copy(tile_rect.translated(QPoint(radius, radius) - blur_rect.topLeft()));
+                tile.blurredGeneration = tile.generation;
+            }
+        }
+    }
+
+    for (int index : paint_tiles) {
+        const QPoint tile_pos((index % blurTileColumns) * BLUR_TILE_SIZE, (index / blurTileColumns) * BLUR_TILE_SIZE);
+
+        pa->drawImage(tile_pos, blurTiles.at(index).image);
+    }
+}
+
 void DBlurEffectWidgetPrivate::setMaskColor(const QColor &color)
 {
     maskColor = color;
@@ -202,6 +458,9 @@ bool DBlurEffectWidgetPrivate::updateWindowBlurArea(QWidget *topLevelWidget)
                 handle.setEnableBlurWindow(true);
             }
 
+            // 关闭全模糊后需要重新提交模糊区域
+            submittedBlurAreaHash.remove(topLevelWidget);
+
             return true;
         }
 
@@ -216,13 +475,14 @@ bool DBlurEffectWidgetPrivate::updateWindowBlurArea(QWidget *topLevelWidget)
 
     if (handle.enableBlurWindow()) {
         handle.setEnableBlurWindow(false);
+        submittedBlurAreaHash.remove(topLevelWidget);
     }
 
-    bool ok = false;
+    WindowBlurArea blurArea;
+    blurArea.window = topLevelWidget;
+    blurArea.winId = topLevelWidget->internalWinId();
 
     if (isExistMaskPath) {
-        QList<QPainterPath> pathList;
-
         Q_FOREACH (const DBlurEffectWidget *w, blurEffectWidgetList) {
             if (!w->d_func()->blurEnabled) {
                 continue;
@@ -242,14 +502,10 @@ bool DBlurEffectWidgetPrivate::updateWindowBlurArea(QWidget *topLevelWidget)
                 p &= w->d_func()->maskPath.translated(r.topLeft());
             }
 
-            pathList << p;
+            blurArea.pathList << p;
         }
-
-        ok = handle.setWindowBlurAreaByWM(pathList);
     } else {
-        QVector<DPlatformWindowHandle::WMBlurArea> areaList;
-
-        areaList.reserve(blurEffectWidgetList.size());
+        blurArea.areaList.reserve(blurEffectWidgetList.size());
 
         Q_FOREACH (const DBlurEffectWidget *w, blurEffectWidgetList) {
             if (!w->d_func()->blurEnabled) {
@@ -264,19 +520,81 @@ bool DBlurEffectWidgetPrivate::updateWindowBlurArea(QWidget *topLevelWidget)
 
             r.moveTopLeft(w->mapTo(topLevelWidget, r.topLeft()));
 
-            areaList << dMakeWMBlurArea(r.x(), r.y(), r.width(), r.height(), w->blurRectXRadius(), w->blurRectYRadius());
+            blurArea.areaList << dMakeWMBlurArea(r.x(), r.y(), r.width(), r.height(), w->blurRectXRadius(), w->blurRectYRadius());
+        }
+    }
+
+    bool ok = true;
+    auto submitted = submittedBlurAreaHash.constFind(topLevelWidget);
+
+    // 和上次提交的区域一致时不再通知窗管
+    if (submitted == submittedBlurAreaHash.constEnd() || !submitted->window || !(*submitted == blurArea)) {
+        if (isExistMaskPath) {
+            ok = handle.setWindowBlurAreaByWM(blurArea.pathList);
+        } else {
+            ok = handle.setWindowBlurAreaByWM(blurArea.areaList);
         }
 
-        ok = handle.setWindowBlurAreaByWM(areaList);
+        if (ok) {
+            // 清理已销毁窗口的记录
+            for (auto it = submittedBlurAreaHash.begin(); it != submittedBlurAreaHash.end();) {
+                it = it->window ? it + 1 : submittedBlurAreaHash.erase(it);
+            }
+
+            submittedBlurAreaHash[topLevelWidget] = blurArea;
+        } else {
+            submittedBlurAreaHash.remove(topLevelWidget);
+        }
     }
 
     if (blurEffectWidgetList.isEmpty()) {
         blurEffectWidgetHash.remove(topLevelWidget);
+        submittedBlurAreaHash.remove(topLevelWidget);
     }
 
     return ok;
 }
 
+void DBlurEffectWidgetPrivate::requestWindowBlurAreaUpdate(QWidget *topLevelWidget, bool force)
+{
+    if (force) {
+        submittedBlurAreaHash.remove(topLevelWidget);
+    }
+
+    // 没有事件循环时直接更新
+    if (!qApp) {
+        updateWindowBlurArea(topLevelWidget);
+        return;
+    }
+
+    for (const QPointer<QWidget> &window : pendingBlurAreaWindows) {
+        if (window == topLevelWidget) {
+            return;
+        }
+    }
+
+    // 列表不为空时已经安排过一次合并提交
+    if (pendingBlurAreaWindows.isEmpty()) {
+        QTimer::singleShot(0, qApp, [] {
+            flushWindowBlurAreaUpdates();
+        });
+    }
+
+    pendingBlurAreaWindows << topLevelWidget;
+}
+
+void DBlurEffectWidgetPrivate::flushWindowBlurAreaUpdates()
+{
+    const QList<QPointer<QWidget>> windows = pendingBlurAreaWindows;
+    pendingBlurAreaWindows.clear();
+
+    for (const QPointer<QWidget> &window : windows) {
+        if (window) {
+            updateWindowBlurArea(window);
+        }
+    }
+}
+
 /*!
  * \~english \class DBlurEffectWidget
  * \~english \brief The DBlurEffectWidget class provides widget that backgrounds are blurred and semitranslucent.
@@ -384,6 +702,16 @@ bool DBlurEffectWidgetPrivate::updateWindowBlurArea(QWidget *topLevelWidget)
  * \~chinese \note 可读可写
  */
 
+/*!
+ * \~chinese \property DBlurEffectWidget::blurQuality
+ * \~chinese \brief 控件自行模糊背景时的质量和性能取舍
+ * \~chinese 模糊半径较大时，先模糊缩小到 1/2 或 1/4 的图像再以双线性插值放大，效果几乎一致但计算量小很多。
+ * \~chinese 默认值为 AutoQuality，根据 radius 与 devicePixelRatio 的乘积自动选择缩小倍数；HighQuality 始终以原始
+ * \~chinese 分辨率模糊；HighPerformance 始终缩小后模糊。
+ * \~chinese \note 可读可写
+ * \~chinese \note 对 BehindWindowBlend 模式无效
+ */
+
 /*!
  * \~chinese \fn DBlurEffectWidget::radiusChanged
  * \~chinese \brief 信号会在 radius 属性的值改变时被发送
@@ -479,7 +807,9 @@ DBlurEffectWidget::DBlurEffectWidget(QWidget *parent)
     QObject::connect(DWindowManagerHelper::instance(), &DWindowManagerHelper::windowManagerChanged, this, [this] {
         D_D(DBlurEffectWidget);
 
-        d->updateWindowBlurArea();
+        // 窗管变化后之前提交的区域已经失效
+        if (QWidget *topLevelWidget = d->windowOfBlurEffectHash.value(this))
+            d->requestWindowBlurAreaUpdate(topLevelWidget, true);
     });
     QObject::connect(DWindowManagerHelper::instance(), &DWindowManagerHelper::hasBlurWindowChanged, this, [this] {
         D_D(DBlurEffectWidget);
@@ -679,6 +1009,17 @@ bool DBlurEffectWidget::blurEnabled() const
     return d->blurEnabled;
 }
 
+/*!
+ * \~chinese \brief DBlurEffectWidget::blurQuality
+ * \~chinese \return 当前的模糊质量
+ */
+DBlurEffectWidget::BlurQuality DBlurEffectWidget::blurQuality() const
+{
+    D_DC(DBlurEffectWidget);
+
+    return d->blurQuality;
+}
+
 /*!
  * \~chinese \brief DBlurEffectWidget::setRadius
  * \~chinese \param radius　模糊区域的圆角大小　如果设定值和原值不一致会发送信号radiusChanged
@@ -858,7 +1199,7 @@ void DBlurEffectWidget::setFull(bool full)
         return;
 
     d->full = full;
-    d->updateWindowBlurArea();
+    d->requestWindowBlurAreaUpdate();
 
     Q_EMIT fullChanged(full);
 }
@@ -875,12 +1216,29 @@ void DBlurEffectWidget::setBlurEnabled(bool blurEnabled)
         return;
 
     d->blurEnabled = blurEnabled;
-    d->updateWindowBlurArea();
+    d->requestWindowBlurAreaUpdate();
     update();
 
     Q_EMIT blurEnabledChanged(d->blurEnabled);
 }
 
+/*!
+ * \~chinese \brief DBlurEffectWidget::setBlurQuality
+ * \~chinese \param blurQuality 设定模糊质量，如果设定值和原值不一致会发送信号blurQualityChanged
+ */
+void DBlurEffectWidget::setBlurQuality(DBlurEffectWidget::BlurQuality blurQuality)
+{
+    D_D(DBlurEffectWidget);
+
+    if (d->blurQuality == blurQuality)
+        return;
+
+    d->blurQuality = blurQuality;
+    update();
+
+    Q_EMIT blurQualityChanged(blurQuality);
+}
+
 inline QRect operator *(const QRect &rect, qreal scale)
 {
     return QRect(rect.left() * scale, rect.top() * scale, rect.width() * scale, rect.height() * scale);
@@ -900,33 +1258,31 @@ void DBlurEffectWidget::updateBlurSourceImage(const QRegion &ren)
 
     const qreal device_pixel_ratio = devicePixelRatioF();
     const QPoint point_offset = mapTo(window(), QPoint(0, 0));
+    const QImage &backing_image = window()->backingStore()->handle()->toImage();
 
     if (d->sourceImage.isNull()) {
         const QRect &tmp_rect = rect().translated(point_offset).adjusted(-d->radius, -d->radius, d->radius, d->radius);
 
-        d->sourceImage = window()->backingStore()->handle()->toImage().copy(tmp_rect * device_pixel_ratio);
-        d->sourceImage = d->sourceImage.scaledToWidth(d->sourceImage.width() / device_pixel_ratio);
-    } else {
-        QPainter pa_image(&d->sourceImage);
-
-        pa_image.setCompositionMode(QPainter::CompositionMode_Source);
+        QImage image = backing_image.copy(tmp_rect * device_pixel_ratio);
+        image = image.scaledToWidth(image.width() / device_pixel_ratio);
 
+        // 和上次源图像的图块哈希比较，只让内容变化的图块重新模糊
+        d->sourceImage = image;
+        d->markChangedBlurTiles();
+    } else {
         if (device_pixel_ratio > 1) {
             const QRect &tmp_rect = this->rect().translated(point_offset);
-            QImage area = window()->backingStore()->handle()->toImage().copy(tmp_rect * device_pixel_ratio);
+            QImage area = backing_image.copy(tmp_rect * device_pixel_ratio);
             area = area.scaledToWidth(area.width() / device_pixel_ratio);
 
             for (const QRect &rect : ren.rects()) {
-                pa_image.drawImage(rect.topLeft() + QPoint(d->radius, d->radius), rect == area.rect() ? area : area.copy(rect));
+                d->updateSourceImage(rect.topLeft() + QPoint(d->radius, d->radius), area, rect);
             }
         } else {
             for (const QRect &rect : ren.rects()) {
-                pa_image.drawImage(rect.topLeft() + QPoint(d->radius, d->radius),
-                                   window()->backingStore()->handle()->toImage().copy(rect.translated(point_offset)));
+                d->updateSourceImage(rect.topLeft() + QPoint(d->radius, d->radius), backing_image, rect.translated(point_offset));
             }
         }
-
-        pa_image.end();
     }
 }
 
@@ -974,25 +1330,20 @@ void DBlurEffectWidget::paintEvent(QPaintEvent *event)
             updateBlurSourceImage(event->region());
         }
 
-        if (d->customSourceImage || !d->sourceImage.isNull()) {
+        if (d->customSourceImage) {
             int radius = d->radius;
             qreal device_pixel_ratio = devicePixelRatioF();
-            QImage image;
             const QRect &paintRect = event->rect();
+            QImage image = d->sourceImage.copy(paintRect.adjusted(0, 0, 2 * radius, 2 * radius) * device_pixel_ratio);
+            image.setDevicePixelRatio(device_pixel_ratio);
+            DBlurEngine::blur(image, radius, false, d->downsampleFactor(d->blurQuality, radius * device_pixel_ratio));
 
-            if (d->customSourceImage) {
-                image = d->sourceImage.copy(paintRect.adjusted(0, 0, 2 * radius, 2 * radius) * device_pixel_ratio);
-                image.setDevicePixelRatio(device_pixel_ratio);
-                pa.setOpacity(0.2);
-            } else {// 非customSourceImage不考虑缩放产生的影响
-                image = d->sourceImage.copy(paintRect.adjusted(0, 0, 2 * radius, 2 * radius));
-            }
-
-            QTransform old_transform = pa.transform();
-            pa.translate(paintRect.topLeft() - QPoint(radius, radius));
-            qt_blurImage(&pa, image, radius, false, false);
-            pa.setTransform(old_transform);
+            pa.setOpacity(0.2);
+            pa.drawImage(paintRect.topLeft() - QPoint(radius, radius), image);
             pa.setOpacity(1);
+        } else if (!d->sourceImage.isNull()) {
+            // 非customSourceImage不考虑缩放产生的影响，背景没有变化时直接绘制缓存的模糊图块
+            d->paintBlurTiles(&pa, event->region());
         } else if (d->group) { // 组模式
             d->group->paint(&pa, this);
         }
@@ -1016,7 +1367,7 @@ void DBlurEffectWidget::moveEvent(QMoveEvent *event)
         return QWidget::moveEvent(event);
     }
 
-    d->updateWindowBlurArea();
+    d->requestWindowBlurAreaUpdate();
 
     QWidget::moveEvent(event);
 }
@@ -1036,7 +1387,7 @@ void DBlurEffectWidget::resizeEvent(QResizeEvent *event)
         return QWidget::resizeEvent(event);
     }
 
-    d->updateWindowBlurArea();
+    d->requestWindowBlurAreaUpdate();
 
     QWidget::resizeEvent(event);
 }
@@ -1160,6 +1511,7 @@ public:
     D_DECLARE_PUBLIC(DBlurEffectGroup)
     QHash<DBlurEffectWidget*, QPoint> effectWidgetMap;
     QPixmap blurPixmap;
+    DBlurEffectWidget::BlurQuality blurQuality = DBlurEffectWidget::AutoQuality;
 };
 
 DBlurEffectGroup::DBlurEffectGroup()
@@ -1189,11 +1541,9 @@ void DBlurEffectGroup::setSourceImage(QImage image, int blurRadius)
 
 
     if (blurRadius > 0) {
-        QImage tmp(image.size(), image.format());
-        QPainter pa(&tmp);
-        qt_blurImage(&pa, image, blurRadius, false, false);
-        pa.end();
-        d->blurPixmap = QPixmap::fromImage(tmp);
+        const int downsample = DBlurEffectWidgetPrivate::downsampleFactor(d->blurQuality, blurRadius * image.devicePixelRatio());
+        DBlurEngine::blur(image, blurRadius, false, downsample);
+        d->blurPixmap = QPixmap::fromImage(image);
     } else {
         d->blurPixmap = QPixmap::fromImage(image);
     }
@@ -1206,6 +1556,29 @@ void DBlurEffectGroup::setSourceImage(QImage image, int blurRadius)
     }
 }
 
+/*!
+ * \~chinese \brief DBlurEffectGroup::blurQuality
+ * \~chinese \return setSourceImage 模糊图像时使用的模糊质量
+ * \~chinese \see DBlurEffectWidget::blurQuality
+ */
+DBlurEffectWidget::BlurQuality DBlurEffectGroup::blurQuality() const
+{
+    D_DC(DBlurEffectGroup);
+
+    return d->blurQuality;
+}
+
+/*!
+ * \~chinese \brief DBlurEffectGroup::setBlurQuality
+ * \~chinese \param blurQuality 设定模糊质量，在下次调用 setSourceImage 时生效
+ */
+void DBlurEffectGroup::setBlurQuality(DBlurEffectWidget::BlurQuality blurQuality)
+{
+    D_D(DBlurEffectGroup);
+
+    d->blurQuality = blurQuality;
+}
+
 void DBlurEffectGroup::addWidget(DBlurEffectWidget *widget, const QPoint &offset)
 {
     if (widget->d_func()->group && widget->d_func()->group != this) {
@@ -42,6 +42,8 @@ class LIBDTKWIDGETSHARED_EXPORT DBlurEffectWidget : public QWidget, public DTK_C
     Q_PROPERTY(quint8 maskAlpha READ maskAlpha WRITE setMaskAlpha NOTIFY maskAlphaChanged)
     Q_PROPERTY(bool full READ isFull WRITE setFull NOTIFY fullChanged)
     Q_PROPERTY(bool blurEnabled READ blurEnabled WRITE setBlurEnabled NOTIFY blurEnabledChanged)
+    // Large radius blurs a scaled down copy of the background, see BlurQuality
+    Q_PROPERTY(BlurQuality blurQuality READ blurQuality WRITE setBlurQuality NOTIFY blurQualityChanged)
 
 public:
     // TODO: To support MeanBlur, MedianBlur, BilateralFilter
@@ -68,6 +70,14 @@ public:
 
     Q_ENUMS(MaskColorType)
 
+    enum BlurQuality {
+        AutoQuality,        // downsample by radius x devicePixelRatio
+        HighQuality,        // always blur in full resolution
+        HighPerformance     // always downsample
+    };
+
+    Q_ENUMS(BlurQuality)
+
     explicit DBlurEffectWidget(QWidget *parent = 0);
     ~DBlurEffectWidget();
 
@@ -80,6 +90,7 @@ public:
 
     bool isFull() const;
     bool blurEnabled() const;
+    BlurQuality blurQuality() const;
 
     QColor maskColor() const;
 
@@ -100,6 +111,7 @@ public Q_SLOTS:
     void setMaskColor(MaskColorType type);
     void setFull(bool full);
     void setBlurEnabled(bool blurEnabled);
+    void setBlurQuality(BlurQuality blurQuality);
 
     void updateBlurSourceImage(const QRegion &ren);
 
@@ -114,6 +126,7 @@ Q_SIGNALS:
     void maskColorChanged(QColor maskColor);
     void fullChanged(bool full);
     void blurEnabledChanged(bool blurEnabled);
+    void blurQualityChanged(BlurQuality blurQuality);
 
     void blurSourceImageDirtied();
 
@@ -142,6 +155,8 @@ public:
     ~DBlurEffectGroup();
 
     void setSourceImage(QImage image, int blurRadius = 35);
+    DBlurEffectWidget::BlurQuality blurQuality() const;
+    void setBlurQuality(DBlurEffectWidget::BlurQuality blurQuality);
     void addWidget(DBlurEffectWidget *widget, const QPoint &offset = QPoint(0, 0));
     void removeWidget(DBlurEffectWidget *widget);
 
@@ -27,6 +27,8 @@
 
 #include <qpa/qplatformbackingstore.h>
 
+#include <cstring>
+
 DWIDGET_BEGIN_NAMESPACE
 
 class DClipEffectWidgetPrivate : public DTK_CORE_NAMESPACE::DObjectPrivate
@@ -34,10 +36,11 @@ class DClipEffectWidgetPrivate : public DTK_CORE_NAMESPACE::DObjectPrivate
 public:
     DClipEffectWidgetPrivate(DClipEffectWidget *qq);
 
-    void updateImage();
+    void updateImage(const QRegion &region);
 
     QImage image;
-    QRectF imageGeometry;
+    // 已经缓存了父控件背景的区域，控件坐标
+    QRegion imageValidRegion;
     QPainterPath path;
     QMargins margins;
 
@@ -52,6 +55,87 @@ DClipEffectWidgetPrivate::DClipEffectWidgetPrivate(DClipEffectWidget *qq)
 
 }
 
+inline QRectF multiply(const QRectF &rect, qreal scale)
+{
+    return QRectF(rect.topLeft() * scale, rect.size() * scale);
+}
+
+inline QRectF divide(const QRectF &rect, qreal scale)
+{
+    return multiply(rect, 1.0 / scale);
+}
+
+void DClipEffectWidgetPrivate::updateImage(const QRegion &region)
+{
+    D_Q(DClipEffectWidget);
+
+    const qreal scale = q->devicePixelRatioF();
+    const QRect &widget_rect = q->rect();
+    const QSize &image_size = multiply(widget_rect, scale).toAlignedRect().size();
+
+    // 只有位置变化时缓存仍然有效，大小变化时保留重叠部分
+    if (!image.isNull() && (image.devicePixelRatio() != scale || image.size() != image_size)) {
+        if (image.devicePixelRatio() == scale) {
+            image = image.copy(QRect(QPoint(0, 0), image_size));
+            image.setDevicePixelRatio(scale);
+            imageValidRegion &= widget_rect;
+        } else {
+            image = QImage();
+        }
+    }
+
+    // 被重绘的区域和尚未缓存的区域需要从 backing store 中复制
+    QRegion dirty = (region | (QRegion(widget_rect) - imageValidRegion)) & widget_rect;
+
+    if (dirty.isEmpty())
+        return;
+
+    const QImage &backing_image = q->window()->backingStore()->handle()->toImage();
+
+    if (image.isNull() || image.format() != backing_image.format()) {
+        image = QImage(image_size, backing_image.format());
+        image.fill(Qt::transparent);
+        image.setDevicePixelRatio(scale);
+        dirty = widget_rect;
+    }
+
+    // 此控件位置一直为 0,0，且大小和父控件一致，所以offset也是父控件相对于顶级窗口的偏移
+    const QPoint &offset = (QPointF(q->mapTo(q->window(), QPoint(0, 0))) * scale).toPoint();
+    const int bytes_per_pixel = image.depth() / 8;
+    QPainter pa;
+
+    for (const QRect &rect : dirty.rects()) {
+        const QRect &source_rect = multiply(rect, scale).toAlignedRect().translated(offset) & backing_image.rect();
+        const QRect &target_rect = source_rect.translated(-offset) & image.rect();
+
+        if (target_rect.isEmpty())
+            continue;
+
+        if (bytes_per_pixel > 0) {
+            for (int y = 0; y < target_rect.height(); ++y) {
+                memcpy(image.scanLine(target_rect.y() + y) + target_rect.x() * bytes_per_pixel,
+                       backing_image.constScanLine(target_rect.y() + offset.y() + y) + (target_rect.x() + offset.x()) * bytes_per_pixel,
+                       target_rect.width() * bytes_per_pixel);
+            }
+        } else {
+            if (!pa.isActive()) {
+                image.setDevicePixelRatio(1);
+                pa.begin(&image);
+                pa.setCompositionMode(QPainter::CompositionMode_Source);
+            }
+
+            pa.drawImage(target_rect.topLeft(), backing_image, target_rect.translated(offset));
+        }
+    }
+
+    if (pa.isActive()) {
+        pa.end();
+        image.setDevicePixelRatio(scale);
+    }
+
+    imageValidRegion |= dirty;
+}
+
 /*!
  * \~chinese \class DClipEffectWidget
  * \~chinese \brief 用于裁剪窗口的绘制内容
@@ -169,59 +253,22 @@ void DClipEffectWidget::setClipPath(const QPainterPath &path)
         return;
 
     d->path = path;
-    d->image = QImage();
 
     Q_EMIT clipPathChanged(d->path);
 
     update();
 }
 
-inline QRectF multiply(const QRectF &rect, qreal scale)
-{
-    return QRectF(rect.topLeft() * scale, rect.size() * scale);
-}
-
-inline QRectF divide(const QRectF &rect, qreal scale)
-{
-    return multiply(rect, 1.0 / scale);
-}
-
 bool DClipEffectWidget::eventFilter(QObject *watched, QEvent *event)
 {
     D_D(DClipEffectWidget);
 
-    if (event->type() == QEvent::Move) {
-        d->image = QImage();
-    }
-
     if (watched != parent())
         return false;
 
     if (event->type() == QEvent::Paint) {
-        const QPoint &offset = mapTo(window(), QPoint(0, 0));
-        const QImage &image = window()->backingStore()->handle()->toImage();
-        qreal scale = devicePixelRatioF();
-
-        d->imageGeometry = QRectF(image.rect()) & multiply(QRect(offset, size()), scale);
-
-        if (d->image.isNull() || d->imageGeometry.size() != d->image.size()) {
-            d->image = image.copy(d->imageGeometry.toRect());
-            d->image.setDevicePixelRatio(scale);
-        } else {
-            QPaintEvent *e = static_cast<QPaintEvent*>(event);
-            QPainter p;
-            // 此控件位置一直为 0,0，且大小和父控件一致，所以offset也是父控件相对于顶级窗口的偏移
-            const QRectF &rect = QRectF(image.rect()) & multiply(e->rect().translated(offset), scale);
-
-            d->image.setDevicePixelRatio(image.devicePixelRatio());
-
-            p.begin(&d->image);
-            p.setCompositionMode(QPainter::CompositionMode_Source);
-            p.drawImage(rect.topLeft() - d->imageGeometry.topLeft(), image.copy(rect.toRect()));
-            p.end();
-
-            d->image.setDevicePixelRatio(scale);
-        }
+        // 只复制父控件本次需要重绘的区域，移动位置不会使缓存失效
+        d->updateImage(static_cast<QPaintEvent*>(event)->region());
     } else if (event->type() == QEvent::Resize) {
         resize(parentWidget()->size());
     }
@@ -238,8 +285,7 @@ void DClipEffectWidget::paintEvent(QPaintEvent *event)
 
     qreal devicePixelRatio = devicePixelRatioF();
     const QRectF &rect = QRectF(event->rect()) & QRectF(this->rect()).marginsRemoved(d->margins);
-    const QPoint &offset = mapTo(window(), QPoint(0, 0));
-    const QRectF &imageRect = multiply(rect, devicePixelRatio) & d->imageGeometry.translated(-offset * devicePixelRatio);
+    const QRectF &imageRect = multiply(rect, devicePixelRatio) & QRectF(d->image.rect());
 
     if (!imageRect.isValid())
         return;
@@ -258,10 +304,7 @@ void DClipEffectWidget::paintEvent(QPaintEvent *event)
 
 void DClipEffectWidget::resizeEvent(QResizeEvent *event)
 {
-    D_D(DClipEffectWidget);
-
-    d->image = QImage();
-
+    // 缓存在父控件下次绘制时按新的大小调整
     QWidget::resizeEvent(event);
 }
 
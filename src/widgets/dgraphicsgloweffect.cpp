@@ -16,10 +16,7 @@
  */
 
 #include "dgraphicsgloweffect.h"
-
-QT_BEGIN_NAMESPACE
-extern Q_WIDGETS_EXPORT void qt_blurImage(QPainter *p, QImage &blurImage, qreal radius, bool quality, bool alphaOnly, int transposed = 0);
-QT_END_NAMESPACE
+#include "private/dblurengine_p.h"
 
 DWIDGET_BEGIN_NAMESPACE
 
@@ -97,13 +94,7 @@ void DGraphicsGlowEffect::draw(QPainter *painter)
     tmpPainter.end();
 
     // blur the alpha channel
-    QImage blurred(tmpImg.size(), QImage::Format_ARGB32_Premultiplied);
-    blurred.fill(0);
-    QPainter blurPainter(&blurred);
-    qt_blurImage(&blurPainter, tmpImg, blurRadius(), false, true);
-    blurPainter.end();
-
-    tmpImg = blurred;
+    DBlurEngine::blur(tmpImg, blurRadius(), true, DBlurEngine::downsampleFactor(blurRadius()));
 
     // blacken the image...
     tmpPainter.begin(&tmpImg);
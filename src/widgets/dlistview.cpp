@@ -158,6 +158,70 @@ void DListViewPrivate::onOrientationChanged()
     }
 }
 
+int DListViewPrivate::laidOutRowCount() const
+{
+    D_QC(DListView);
+
+    const QAbstractItemModel *model = q->model();
+
+    if (!model)
+        return 0;
+
+    const QModelIndex &root = q->rootIndex();
+    const int column = q->modelColumn();
+    const int count = model->rowCount(root);
+    int low = 0;
+    int high = count;
+
+    // 分批布局总是从第一行开始依次布局，尚未布局的项和隐藏的项区域为空，
+    // 高度为 0 的项区域无效但不为空，隐藏的项按其后第一个未隐藏的项判断
+    while (low < high) {
+        const int middle = low + (high - low) / 2;
+        int row = middle;
+
+        while (row < high && q->isRowHidden(row))
+            ++row;
+
+        if (row == high) {
+            high = middle;
+        } else if (!q->visualRect(model->index(row, column, root)).isNull()) {
+            low = row + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    // 末尾连续隐藏的项不需要等待布局
+    int row = low;
+
+    while (row < count && q->isRowHidden(row))
+        ++row;
+
+    return row == count ? count : low;
+}
+
+void DListViewPrivate::updateLayoutProgress()
+{
+    D_Q(DListView);
+
+    if (q->layoutMode() != QListView::Batched || !q->model())
+        return;
+
+    const int total = q->model()->rowCount(q->rootIndex());
+
+    // 布局完成后不再查找，直到重新布局
+    if (layoutProgress == total)
+        return;
+
+    int laid_out = laidOutRowCount();
+
+    if (laid_out == layoutProgress)
+        return;
+
+    layoutProgress = laid_out;
+    Q_EMIT q->layoutProgressChanged(laid_out, total);
+}
+
 // ====================Signals begin====================
 /**
  * \~chinese \fn DListView::currentChanged
@@ -180,6 +244,20 @@ void DListViewPrivate::onOrientationChanged()
  *
  * \~chinese \sa QModelIndex QAbstractItemView::EditTrigger
  */
+
+/**
+ * \~chinese \fn DListView::layoutProgressChanged
+ * \~chinese \brief 这个信号在分批布局的进度发生改变时被调用
+ *
+ * \~chinese 只有 layoutMode 为 QListView::Batched 时才会发出，布局在事件循环空闲时每次处理 batchSize 个项，
+ * \~chinese laidOutRows 等于 totalRows 时布局完成。所有项尺寸相同时应该使用 QListView::setUniformItemSizes ，
+ * \~chinese 此时只会测量一个项，不需要分批布局。
+ *
+ * \~chinese \param laidOutRows 已经完成布局的行数
+ * \~chinese \param totalRows 总行数
+ *
+ * \~chinese \sa QListView::setLayoutMode QListView::setBatchSize DStyledItemDelegate::setUniformItemSizes
+ */
 // ====================Signals end====================
 
 /**
@@ -244,6 +322,21 @@ int DListView::horizontalOffset() const
     return -(viewport()->width() - width) / 2 + offset;
 }
 
+/*!
+ * \~chinese \brief DListView::doItemsLayout 重新布局所有项
+ *
+ * \~chinese 分批布局模式下只会同步布局第一批项，其余的项在事件循环空闲时继续布局，
+ * \~chinese 并通过 layoutProgressChanged 通知进度。
+ */
+void DListView::doItemsLayout()
+{
+    D_D(DListView);
+
+    d->layoutProgress = -1;
+    QListView::doItemsLayout();
+    d->updateLayoutProgress();
+}
+
 QSize DListView::minimumSizeHint() const
 {
     QSize size = QListView::minimumSizeHint();
@@ -805,6 +898,16 @@ void DListView::resizeEvent(QResizeEvent *event)
     }
 }
 
+void DListView::timerEvent(QTimerEvent *event)
+{
+    QListView::timerEvent(event);
+
+    D_D(DListView);
+
+    // 分批布局由 QListView 的定时器驱动，每处理一批后更新进度，布局完成后其它定时器不会再触发查找
+    d->updateLayoutProgress();
+}
+
 void DListView::currentChanged(const QModelIndex &current, const QModelIndex &previous)
 {
     QListView::currentChanged(current, previous);
@@ -74,6 +74,7 @@ public:
 
     void setModel(QAbstractItemModel *model) Q_DECL_OVERRIDE;
     QSize minimumSizeHint() const Q_DECL_OVERRIDE;
+    void doItemsLayout() Q_DECL_OVERRIDE;
 
     DStyledItemDelegate::BackgroundType backgroundType() const;
     QMargins itemMargins() const;
@@ -111,6 +112,7 @@ Q_SIGNALS:
     void orientationChanged(Qt::Orientation orientation);
     void currentChanged(const QModelIndex &previous);
     void triggerEdit(const QModelIndex &index);
+    void layoutProgressChanged(int laidOutRows, int totalRows);
 
 protected:
 #if(QT_VERSION < 0x050500)
@@ -120,6 +122,7 @@ protected:
 #endif
 
     void resizeEvent(QResizeEvent *event) Q_DECL_OVERRIDE;
+    void timerEvent(QTimerEvent *event) Q_DECL_OVERRIDE;
     void currentChanged(const QModelIndex &current, const QModelIndex &previous) Q_DECL_OVERRIDE;
     bool edit(const QModelIndex &index, EditTrigger trigger, QEvent *event) Q_DECL_OVERRIDE;
 
@@ -20,6 +20,7 @@
 
 #include "dloadingindicator.h"
 #include "private/dloadingindicator_p.h"
+#include "private/danimationclock_p.h"
 #include "dthememanager.h"
 
 DWIDGET_BEGIN_NAMESPACE
@@ -131,6 +132,8 @@ DLoadingIndicator::~DLoadingIndicator()
 {
     D_DC(DLoadingIndicator);
 
+    DAnimationClock::unregisterWidget(this);
+
     if(d->widgetSource)
         d->widgetSource->deleteLater();
 }
@@ -313,7 +316,8 @@ bool DLoadingIndicator::loading() const
 {
     D_DC(DLoadingIndicator);
 
-    return d->rotateAni.state() == QVariantAnimation::Running;
+    // 控件不可见时动画被暂停，仍然属于加载状态
+    return d->rotateAni.state() != QVariantAnimation::Stopped;
 }
 
 /*!
@@ -472,6 +476,15 @@ void DLoadingIndicator::start()
     D_D(DLoadingIndicator);
 
     d->rotateAni.start();
+
+    // 旋转动画和时钟由同一个 Qt 动画定时器驱动，这里只使用时钟检查可见性，不可见时暂停动画
+    DAnimationClock::registerWidget(this, 200, DAnimationClock::TickFunction(), [d] (bool paused) {
+        if (paused && d->rotateAni.state() == QVariantAnimation::Running) {
+            d->rotateAni.pause();
+        } else if (!paused && d->rotateAni.state() == QVariantAnimation::Paused) {
+            d->rotateAni.resume();
+        }
+    });
 }
 
 /*!
@@ -484,6 +497,7 @@ void DLoadingIndicator::stop()
 {
     D_D(DLoadingIndicator);
 
+    DAnimationClock::unregisterWidget(this);
     d->rotateAni.stop();
 }
 
@@ -17,6 +17,7 @@
 
 #include "dpicturesequenceview.h"
 #include "private/dpicturesequenceview_p.h"
+#include "private/danimationclock_p.h"
 
 #include <QGraphicsPixmapItem>
 #include <QImageReader>
@@ -32,6 +33,10 @@ DPictureSequenceViewPrivate::DPictureSequenceViewPrivate(DPictureSequenceView *q
 
 DPictureSequenceViewPrivate::~DPictureSequenceViewPrivate()
 {
+    D_Q(DPictureSequenceView);
+
+    DAnimationClock::unregisterWidget(q);
+
     for (auto *item : pictureItemList)
     {
         scene->removeItem(item);
@@ -46,21 +51,29 @@ void DPictureSequenceViewPrivate::init()
     D_Q(DPictureSequenceView);
 
     scene = new QGraphicsScene(q);
-    refreshTimer = new QTimer(q);
-    refreshTimer->setInterval(33);
 
     q->setScene(scene);
     q->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
     q->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
     q->setFrameShape(QFrame::NoFrame);
 
-    q->connect(refreshTimer, SIGNAL(timeout()), q, SLOT(_q_refreshPicture()));
     q->viewport()->setAccessibleName("DPictureSequenceViewport");
 }
 
 void DPictureSequenceViewPrivate::play()
 {
-    refreshTimer->start();
+    D_Q(DPictureSequenceView);
+
+    DAnimationClock::registerWidget(q, speed, [this] {
+        _q_refreshPicture();
+    });
+}
+
+void DPictureSequenceViewPrivate::pause()
+{
+    D_Q(DPictureSequenceView);
+
+    DAnimationClock::unregisterWidget(q);
 }
 
 QPixmap DPictureSequenceViewPrivate::loadPixmap(const QString &path)
@@ -99,7 +112,7 @@ void DPictureSequenceViewPrivate::_q_refreshPicture()
         lastItemPos = 0;
 
         if (singleShot)
-            refreshTimer->stop();
+            pause();
 
         D_QC(DPictureSequenceView);
 
@@ -254,7 +267,7 @@ void DPictureSequenceView::pause()
 {
     D_D(DPictureSequenceView);
 
-    d->refreshTimer->stop();
+    d->pause();
 }
 
 /*!
@@ -267,7 +280,7 @@ void DPictureSequenceView::stop()
 {
     D_D(DPictureSequenceView);
 
-    d->refreshTimer->stop();
+    d->pause();
     if (d->pictureItemList.count() > d->lastItemPos)
         d->pictureItemList[d->lastItemPos]->hide();
     if (!d->pictureItemList.isEmpty())
@@ -279,14 +292,15 @@ int DPictureSequenceView::speed() const
 {
     D_DC(DPictureSequenceView);
 
-    return d->refreshTimer->interval();
+    return d->speed;
 }
 
 void DPictureSequenceView::setSpeed(int speed)
 {
     D_D(DPictureSequenceView);
 
-    d->refreshTimer->setInterval(speed);
+    d->speed = speed;
+    DAnimationClock::setInterval(this, speed);
 }
 
 bool DPictureSequenceView::singleShot() const
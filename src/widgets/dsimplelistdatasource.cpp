@@ -0,0 +1,97 @@
+/* -*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+ * -*- coding: utf-8 -*-
+ *
+ * Copyright (C) 2011 ~ 2020 Deepin, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "dsimplelistdatasource.h"
+
+DWIDGET_BEGIN_NAMESPACE
+
+/*!
+ * \~chinese \class DSimpleListDataSource
+ * \~chinese \brief DSimpleListDataSource 为 DSimpleListView 提供行数据，不需要为每一行创建 DSimpleListItem 对象。
+ */
+
+DSimpleListDataSource::~DSimpleListDataSource()
+{
+
+}
+
+/*!
+ * \~chinese \brief 行的键，刷新后键相同的行保持选中、悬停状态和顺序，默认为空
+ */
+QString DSimpleListDataSource::rowKey(int row) const
+{
+    Q_UNUSED(row)
+
+    return QString();
+}
+
+/*!
+ * \~chinese \brief 比较两行用于排序，默认不排序
+ */
+bool DSimpleListDataSource::lessThan(int row1, int row2, int column, bool descendingSort) const
+{
+    Q_UNUSED(row1)
+    Q_UNUSED(row2)
+    Q_UNUSED(column)
+    Q_UNUSED(descendingSort)
+
+    return false;
+}
+
+/*!
+ * \~chinese \brief 行的排序键，视图缓存排序键并用其代替 lessThan 比较，默认无排序键
+ */
+QVariant DSimpleListDataSource::sortKey(int row, int column) const
+{
+    Q_UNUSED(row)
+    Q_UNUSED(column)
+
+    return QVariant();
+}
+
+/*!
+ * \~chinese \brief 搜索时过滤行，默认所有行都匹配。匹配某个内容的行也必须匹配该内容的所有前缀，追加搜索内容时视图只在上次的结果中搜索
+ */
+bool DSimpleListDataSource::matches(int row, const QString &searchContent) const
+{
+    Q_UNUSED(row)
+    Q_UNUSED(searchContent)
+
+    return true;
+}
+
+/*!
+ * \~chinese \brief 是否可以在工作线程中调用 matches 和 lessThan，默认不可以
+ */
+bool DSimpleListDataSource::canMatchConcurrently() const
+{
+    return false;
+}
+
+/*!
+ * \~chinese \class DSimpleListDelegate
+ * \~chinese \brief DSimpleListDelegate 负责绘制 DSimpleListDataSource 的行。
+ */
+
+DSimpleListDelegate::~DSimpleListDelegate()
+{
+
+}
+
+DWIDGET_END_NAMESPACE
@@ -0,0 +1,131 @@
+/* -*- Mode: C++; indent-tabs-mode: nil; tab-width: 4 -*-
+ * -*- coding: utf-8 -*-
+ *
+ * Copyright (C) 2011 ~ 2020 Deepin, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DSIMPLELISTDATASOURCE_H
+#define DSIMPLELISTDATASOURCE_H
+
+#include <dtkwidget_global.h>
+#include <QPainter>
+#include <QString>
+#include <QVariant>
+
+DWIDGET_BEGIN_NAMESPACE
+
+/*
+ * DSimpleListDataSource provides the rows of DSimpleListView without a DSimpleListItem object per row.
+ * Rows are addressed by index, the view only keeps the row indexes and the row keys.
+ * Call DSimpleListView::refreshRows after the rows changed.
+ */
+class LIBDTKWIDGETSHARED_EXPORT DSimpleListDataSource
+{
+public:
+    virtual ~DSimpleListDataSource();
+
+    /*
+     * The number of rows.
+     */
+    virtual int rowCount() const = 0;
+
+    /*
+     * The stable key of row, DSimpleListView keeps selection, hover and row order of rows
+     * with same key when refreshed. Return the same QString object stored by the data source
+     * when possible, the view keeps a shallow copy of each key.
+     *
+     * @row the index of row
+     */
+    virtual QString rowKey(int row) const;
+
+    /*
+     * Compare two rows to sort the column.
+     * Sorting is stable, big lists are sorted on multiple threads.
+     *
+     * @row1 the index of first row
+     * @row2 the index of second row
+     * @column the column to sort
+     * @descendingSort whether sort column descending
+     * @return return true if row1 should be displayed before row2
+     */
+    virtual bool lessThan(int row1, int row2, int column, bool descendingSort) const;
+
+    /*
+     * The sort key of row, DSimpleListView caches the keys of column until rows changed
+     * and compares keys instead of calling lessThan. Numbers compare by value, other keys
+     * compare as string, return an invalid QVariant to sort column with lessThan.
+     *
+     * @row the index of row
+     * @column the column to sort
+     */
+    virtual QVariant sortKey(int row, int column) const;
+
+    /*
+     * Filter rows when search.
+     * Rows matching a content must also match every prefix of it, DSimpleListView only
+     * searches rows of the last search when the search content is extended.
+     *
+     * @row the index of row
+     * @searchContent the content to search
+     * @return return true if row matches searchContent
+     */
+    virtual bool matches(int row, const QString &searchContent) const;
+
+    /*
+     * Whether matches and lessThan can be called from worker threads when searching or sorting many rows.
+     * Only return true if they are thread safe against changes of rows, DSimpleListView
+     * waits for the running search before refreshRows and setDataSource.
+     */
+    virtual bool canMatchConcurrently() const;
+};
+
+/*
+ * DSimpleListDelegate draws the rows of DSimpleListDataSource.
+ */
+class LIBDTKWIDGETSHARED_EXPORT DSimpleListDelegate
+{
+public:
+    virtual ~DSimpleListDelegate();
+
+    /*
+     * Draw background of row, such as background and selected effect.
+     *
+     * @rect row corresponding to the drawing of the rectangular area
+     * @painter the painter used to draw anything you want
+     * @row the index of row in data source
+     * @index the index of row in view, you can draw different rows effect based on the index, such as the zebra crossing
+     * @isSelect current row is selected
+     * @isHover current row is hovered
+     */
+    virtual void drawBackground(QRect rect, QPainter *painter, int row, int index, bool isSelect, bool isHover) = 0;
+
+    /*
+     * Draw foreground of row.
+     *
+     * @rect column corresponding to the drawing of the rectangular area
+     * @painter the painter used to draw anything you want
+     * @column the column of row
+     * @row the index of row in data source
+     * @index the index of row in view
+     * @isSelect current row is selected
+     * @isHover current row is hovered
+     */
+    virtual void drawForeground(QRect rect, QPainter *painter, int column, int row, int index, bool isSelect, bool isHover) = 0;
+};
+
+DWIDGET_END_NAMESPACE
+
+#endif
@@ -30,14 +30,146 @@
 #include <QStyleFactory>
 #include <QWheelEvent>
 #include <QtMath>
-#include <QPointer>
 #include <QPainterPath>
+#include <QHash>
+#include <QSet>
+#include <QThread>
+#include <QFutureWatcher>
+#include <QtConcurrent/QtConcurrent>
+
+#include <algorithm>
+#include <numeric>
 
 #include "dhidpihelper.h"
 
 DCORE_USE_NAMESPACE
 DWIDGET_BEGIN_NAMESPACE
 
+// Search runs on a worker thread from this many rows.
+static const int CONCURRENT_SEARCH_MIN_ROWS = 5000;
+// Every thread sorts at least this many rows.
+static const int CONCURRENT_SORT_MIN_ROWS = 10000;
+
+class DSimpleListViewPrivate;
+
+static QVector<int> matchRows(const DSimpleListDataSource *source, const QVector<int> &rows, const QString &content, QSharedPointer<QAtomicInt> canceled)
+{
+    QVector<int> searchRows;
+
+    for (int row : rows) {
+        // Stop if search is replaced by new search.
+        if (canceled && canceled->loadAcquire()) {
+            break;
+        }
+
+        if (source->matches(row, content)) {
+            searchRows.append(row);
+        }
+    }
+
+    return searchRows;
+}
+
+static bool isNumberSortKey(const QVariant &key)
+{
+    switch (static_cast<int>(key.type())) {
+    case QMetaType::Int:
+    case QMetaType::UInt:
+    case QMetaType::Long:
+    case QMetaType::ULong:
+    case QMetaType::LongLong:
+    case QMetaType::ULongLong:
+    case QMetaType::Float:
+    case QMetaType::Double:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static int compareSortKeys(const QVariant &key1, const QVariant &key2)
+{
+    if (isNumberSortKey(key1) && isNumberSortKey(key2)) {
+        double number1 = key1.toDouble();
+        double number2 = key2.toDouble();
+
+        return number1 < number2 ? -1 : (number2 < number1 ? 1 : 0);
+    }
+
+    return QString::compare(key1.toString(), key2.toString());
+}
+
+template <typename LessThan>
+static void stableSortRows(QVector<int> &rows, LessThan lessThan, bool concurrent)
+{
+    // Refreshed lists keep their previous order, don't sort them again if no row moved.
+    if (std::is_sorted(rows.begin(), rows.end(), lessThan)) {
+        return;
+    }
+
+    int chunkCount = concurrent ? std::min(QThread::idealThreadCount(), rows.count() / CONCURRENT_SORT_MIN_ROWS) : 1;
+
+    if (chunkCount < 2) {
+        std::stable_sort(rows.begin(), rows.end(), lessThan);
+        return;
+    }
+
+    // Sort chunks concurrently, then merge neighbouring chunks, merge keeps equal rows in order.
+    int *data = rows.data();
+    QVector<QPair<int, int>> chunks;
+    for (int i = 0; i < chunkCount; i++) {
+        chunks << qMakePair(rows.count() * i / chunkCount, rows.count() * (i + 1) / chunkCount);
+    }
+
+    QtConcurrent::blockingMap(chunks, [data, lessThan](const QPair<int, int> &chunk) {
+        std::stable_sort(data + chunk.first, data + chunk.second, lessThan);
+    });
+
+    while (chunks.count() > 1) {
+        QVector<QPair<int, int>> mergedChunks;
+        QVector<int> middles;
+
+        for (int i = 0; i + 1 < chunks.count(); i += 2) {
+            mergedChunks << qMakePair(chunks[i].first, chunks[i + 1].second);
+            middles << chunks[i].second;
+        }
+
+        QVector<int> merges(middles.count());
+        std::iota(merges.begin(), merges.end(), 0);
+        QtConcurrent::blockingMap(merges, [data, lessThan, &mergedChunks, &middles](int index) {
+            std::inplace_merge(data + mergedChunks[index].first, data + middles[index], data + mergedChunks[index].second, lessThan);
+        });
+
+        if (chunks.count() % 2 == 1) {
+            mergedChunks << chunks.last();
+        }
+
+        chunks = mergedChunks;
+    }
+}
+
+// Adapts DSimpleListItem objects to the row based data source, so the item API keeps working.
+class DSimpleListItemSource : public DSimpleListDataSource, public DSimpleListDelegate
+{
+public:
+    explicit DSimpleListItemSource(DSimpleListViewPrivate *view) : view(view) {}
+
+    int rowCount() const override;
+    QString rowKey(int row) const override;
+    bool lessThan(int row1, int row2, int column, bool descendingSort) const override;
+    QVariant sortKey(int row, int column) const override;
+    bool matches(int row, const QString &searchContent) const override;
+    bool canMatchConcurrently() const override;
+
+    void drawBackground(QRect rect, QPainter *painter, int row, int index, bool isSelect, bool isHover) override;
+    void drawForeground(QRect rect, QPainter *painter, int column, int row, int index, bool isSelect, bool isHover) override;
+
+    QList<DSimpleListItem*> items;
+
+private:
+    DSimpleListViewPrivate *view;
+};
+
 class DSimpleListViewPrivate : public DTK_CORE_NAMESPACE::DObjectPrivate
 {
 public:
@@ -46,18 +178,44 @@ public:
 
         }
 
-    QList<DSimpleListItem*> getSearchItems(QList<DSimpleListItem*> items);
+    bool isItemMode() const;
+    bool canSort() const;
+    void applySearchRows(const QString &content, const QVector<int> &rows);
+    void cancelSearch();
+    void finishSearch();
+    const QVector<QVariant> *getSortKeys(int column);
+    DSimpleListItem *itemAt(int row) const;
+    QList<DSimpleListItem*> itemsAt(const QList<int> &rows) const;
+    QList<int> rowsOf(const QList<DSimpleListItem*> &items) const;
+    QVector<int> getAllRows() const;
+    QVector<int> getSearchRows(const QVector<int> &rows) const;
+    QVector<QString> getSourceKeys() const;
     int getItemsTotalHeight();
     int getTopRenderOffset();
-    void sortItemsByColumn(int column, bool descendingSort);
-
-    QPointer<DSimpleListItem> lastHoverItem;
-    QPointer<DSimpleListItem> lastSelectItem;
-    QPointer<DSimpleListItem> drawHoverItem;
-    QPointer<DSimpleListItem> mouseHoverItem;
-    QList<DSimpleListItem*> *listItems;
-    QList<DSimpleListItem*> *renderItems;
-    QList<DSimpleListItem*> *selectionItems;
+    void cacheSortKeys();
+    void remapRows(const QVector<QString> &oldKeys, const QVector<QString> &newKeys);
+    void removeRow(int row);
+    void resetRows();
+    void resizeSortingOrderes();
+    void sortRowsByColumn(int column, bool descendingSort);
+
+    // Rows are indexes of source, -1 means no row.
+    DSimpleListItemSource *itemSource;
+    DSimpleListDataSource *source;
+    DSimpleListDelegate *delegate;
+    QVector<int> renderRows;
+    QVector<QString> sourceKeys;
+    QList<int> selectionRows;
+    QHash<int, QVector<QVariant>> sortKeys;
+    QList<SortKeyAlgorithm> sortKeyAlgorithms;
+    QFutureWatcher<QVector<int>> *searchWatcher;
+    QSharedPointer<QAtomicInt> searchCanceled;
+    QString pendingSearchContent;
+    bool searchPending;
+    int lastHoverRow;
+    int lastSelectRow;
+    int drawHoverRow;
+    int mouseHoverRow;
     QList<QString> columnTitles;
     QList<SortAlgorithm> *sortingAlgorithms;
     QList<bool> *sortingOrderes;
@@ -65,6 +223,7 @@ public:
     QString searchContent;
     QTimer *hideScrollbarTimer;
     SearchAlgorithm searchAlgorithm;
+    KeyAlgorithm keyAlgorithm;
     bool defaultSortingOrder;
     bool mouseAtScrollArea;
     bool mouseDragScrollbar;
@@ -92,9 +251,60 @@ public:
     int titlePadding;
     int titlePressColumn;
 
+    // Column geometry and clip paths are cached between paints.
+    QList<int> renderWidths;
+    QList<bool> renderWidthsColumnVisibles;
+    int renderWidthsWidth = -1;
+    QSize framePathSize;
+    QPainterPath framePath;
+    QPainterPath contentPath;
+
     D_DECLARE_PUBLIC(DSimpleListView)
 };
 
+int DSimpleListItemSource::rowCount() const
+{
+    return items.count();
+}
+
+QString DSimpleListItemSource::rowKey(int row) const
+{
+    return view->keyAlgorithm != NULL ? view->keyAlgorithm(items[row]) : QString();
+}
+
+bool DSimpleListItemSource::lessThan(int row1, int row2, int column, bool descendingSort) const
+{
+    return (*view->sortingAlgorithms)[column](items[row1], items[row2], descendingSort);
+}
+
+QVariant DSimpleListItemSource::sortKey(int row, int column) const
+{
+    SortKeyAlgorithm algorithm = view->sortKeyAlgorithms.value(column);
+
+    return algorithm != NULL ? algorithm(items[row]) : QVariant();
+}
+
+bool DSimpleListItemSource::matches(int row, const QString &searchContent) const
+{
+    return view->searchAlgorithm == NULL || view->searchAlgorithm(items[row], searchContent);
+}
+
+bool DSimpleListItemSource::canMatchConcurrently() const
+{
+    // Search and sort algorithms of items were always called in the GUI thread, keep them there.
+    return false;
+}
+
+void DSimpleListItemSource::drawBackground(QRect rect, QPainter *painter, int row, int index, bool isSelect, bool isHover)
+{
+    items[row]->drawBackground(rect, painter, index, isSelect, isHover);
+}
+
+void DSimpleListItemSource::drawForeground(QRect rect, QPainter *painter, int column, int row, int index, bool isSelect, bool isHover)
+{
+    items[row]->drawForeground(rect, painter, column, index, isSelect, isHover);
+}
+
 /*!
  * \~chinese \class DSimpleListView
  * \~chinese \brief DSimpleListView 是 deepin 基于 QWidget 从零绘制的列表控件。
@@ -118,6 +328,7 @@ DSimpleListView::DSimpleListView(QWidget *parent) : QWidget(parent), DObject(*ne
 
     d->searchContent = "";
     d->searchAlgorithm = NULL;
+    d->keyAlgorithm = NULL;
 
     d->titleHoverColumn = -1;
     d->titlePressColumn = -1;
@@ -143,14 +354,14 @@ DSimpleListView::DSimpleListView(QWidget *parent) : QWidget(parent), DObject(*ne
     arrowDownHoverImage = arrowDownLightHoverImage;
     arrowDownPressImage = arrowDownLightPressImage;
 
-    d->listItems = new QList<DSimpleListItem*>();
-    d->renderItems = new QList<DSimpleListItem*>();
-    d->selectionItems = new QList<DSimpleListItem*>();
-    d->lastSelectItem = NULL;
-    d->lastHoverItem = NULL;
+    d->itemSource = new DSimpleListItemSource(d);
+    d->source = d->itemSource;
+    d->delegate = d->itemSource;
+    d->lastSelectRow = -1;
+    d->lastHoverRow = -1;
     d->lastHoverColumnIndex = -1;
-    d->drawHoverItem = NULL;
-    d->mouseHoverItem = NULL;
+    d->drawHoverRow = -1;
+    d->mouseHoverRow = -1;
 
     d->mouseAtScrollArea = false;
     d->mouseDragScrollbar = false;
@@ -170,19 +381,38 @@ DSimpleListView::DSimpleListView(QWidget *parent) : QWidget(parent), DObject(*ne
 
     d->sortingAlgorithms = new QList<SortAlgorithm>();
     d->sortingOrderes = new QList<bool>();
+    d->defaultSortingColumn = -1;
+    d->defaultSortingOrder = false;
+
+    d->searchPending = false;
+    d->searchWatcher = new QFutureWatcher<QVector<int>>(this);
+    connect(d->searchWatcher, &QFutureWatcherBase::finished, this, [d] {
+        // Ignore finished of the canceled search.
+        if (d->searchWatcher->isFinished()) {
+            d->finishSearch();
+        }
+    });
 }
 
 DSimpleListView::~DSimpleListView()
 {
     D_D(DSimpleListView);
 
-    delete d->lastHoverItem.data();
-    delete d->lastSelectItem.data();
-    delete d->drawHoverItem.data();
-    delete d->mouseHoverItem.data();
-    delete d->listItems;
-    delete d->renderItems;
-    delete d->selectionItems;
+    d->cancelSearch();
+
+    if (d->isItemMode()) {
+        // Tracked rows may point to the same item, delete every item once.
+        QSet<DSimpleListItem*> trackedItems;
+        for (int row : {d->lastHoverRow, d->lastSelectRow, d->drawHoverRow, d->mouseHoverRow}) {
+            if (DSimpleListItem *item = d->itemAt(row)) {
+                trackedItems.insert(item);
+            }
+        }
+
+        qDeleteAll(trackedItems);
+    }
+
+    delete d->itemSource;
     delete d->sortingAlgorithms;
     delete d->sortingOrderes;
     delete d->hideScrollbarTimer;
@@ -227,6 +457,14 @@ void DSimpleListView::setColumnTitleInfo(QList<QString> titles, QList<int> width
 
     // Set title height.
     d->titleHeight = height;
+
+    // Data source compares rows itself, only sorting orders are needed for every column.
+    if (!d->isItemMode()) {
+        d->resizeSortingOrderes();
+    }
+
+    d->renderWidthsWidth = -1;
+    d->framePathSize = QSize();
 }
 
 /*!
@@ -275,9 +513,31 @@ void DSimpleListView::setSearchAlgorithm(SearchAlgorithm algorithm)
 {
     D_D(DSimpleListView);
 
+    d->finishSearch();
     d->searchAlgorithm = algorithm;
 }
 
+/*!
+ * \~chinese \brief 设置列排序键算法，排序键缓存到列表项改变，比较排序键代替调用排序算法
+ */
+void DSimpleListView::setColumnSortKeyAlgorithms(QList<SortKeyAlgorithm> algorithms)
+{
+    D_D(DSimpleListView);
+
+    d->sortKeyAlgorithms = algorithms;
+    d->sortKeys.clear();
+}
+
+/*!
+ * \~chinese \brief 设置列表项的键算法，refreshItems 通过键匹配新旧列表项
+ */
+void DSimpleListView::setKeyAlgorithm(KeyAlgorithm algorithm)
+{
+    D_D(DSimpleListView);
+
+    d->keyAlgorithm = algorithm;
+}
+
 /*!
  * \~chinese \brief 设置圆角半径
  */
@@ -286,6 +546,7 @@ void DSimpleListView::setClipRadius(int radius)
     D_D(DSimpleListView);
 
     d->clipRadius = radius;
+    d->framePathSize = QSize();
 }
 
 /*!
@@ -303,6 +564,62 @@ void DSimpleListView::setFrame(bool enableFrame, QColor color, double opacity)
     frameOpacity = opacity;
 }
 
+/*!
+ * \~chinese \brief 设置数据源和绘制代理，设置为空时恢复使用 DSimpleListItem 列表项
+ */
+void DSimpleListView::setDataSource(DSimpleListDataSource *source, DSimpleListDelegate *delegate, int sortColumn, bool descendingSort)
+{
+    D_D(DSimpleListView);
+
+    Q_ASSERT_X((source == NULL) == (delegate == NULL), "setDataSource", "source and delegate must be set together.");
+
+    d->finishSearch();
+
+    if (source == NULL || delegate == NULL) {
+        d->source = d->itemSource;
+        d->delegate = d->itemSource;
+        d->sourceKeys.clear();
+    } else {
+        d->source = source;
+        d->delegate = delegate;
+        d->sourceKeys = d->getSourceKeys();
+
+        d->resizeSortingOrderes();
+        d->defaultSortingColumn = sortColumn;
+        d->defaultSortingOrder = descendingSort;
+    }
+
+    d->resetRows();
+    d->renderOffset = d->getTopRenderOffset();
+
+    update();
+}
+
+/*!
+ * \~chinese \brief 数据源的行改变后刷新视图，键相同的行保持选中状态和顺序
+ * \~chinese \brief 排序列的键没有改变且没有新行时不重新排序
+ */
+void DSimpleListView::refreshRows()
+{
+    D_D(DSimpleListView);
+
+    if (d->isItemMode()) {
+        return;
+    }
+
+    d->finishSearch();
+
+    QVector<QString> keys = d->getSourceKeys();
+    d->remapRows(d->sourceKeys, keys);
+    d->sourceKeys = keys;
+
+    // Keep scroll position.
+    d->renderOffset = adjustRenderOffset(d->renderOffset);
+
+    // Painted content may change without changing any sort key, repaint all visible rows.
+    update();
+}
+
 /*!
  * \~chinese \brief 添加 DSimpleListItem 列表到视图中
  */
@@ -310,18 +627,30 @@ void DSimpleListView::addItems(QList<DSimpleListItem*> items)
 {
     D_D(DSimpleListView);
 
+    if (!d->isItemMode()) {
+        return;
+    }
+
+    d->finishSearch();
+    d->sortKeys.clear();
+
     // Add item to list.
-    d->listItems->append(items);
-    QList<DSimpleListItem*> searchItems = d->getSearchItems(items);
-    d->renderItems->append(searchItems);
+    QVector<int> rows;
+    rows.reserve(items.count());
+    for (int i = 0; i < items.count(); i++) {
+        rows << d->itemSource->items.count() + i;
+    }
+
+    d->itemSource->items.append(items);
+    d->renderRows << d->getSearchRows(rows);
 
     // If user has click title to sort, sort items after add items to list.
     if (d->defaultSortingColumn != -1) {
-        d->sortItemsByColumn(d->defaultSortingColumn, d->defaultSortingOrder);
+        d->sortRowsByColumn(d->defaultSortingColumn, d->defaultSortingOrder);
     }
 
     // Repaint after add items.
-    repaint();
+    update();
 }
 
 /*!
@@ -331,14 +660,18 @@ void DSimpleListView::removeItem(DSimpleListItem* item)
 {
     D_D(DSimpleListView);
 
-    d->listItems->removeOne(item);
-    d->renderItems->removeOne(item);
+    if (!d->isItemMode()) {
+        return;
+    }
+
+    d->finishSearch();
+    d->removeRow(d->itemSource->items.indexOf(item));
 
     if (d->renderOffset >= d->getItemsTotalHeight() - rect().height()) {
         d->renderOffset = adjustRenderOffset(d->renderOffset - d->rowHeight);
     }
 
-    repaint();
+    update();
 }
 
 /*!
@@ -348,11 +681,16 @@ void DSimpleListView::clearItems()
 {
     D_D(DSimpleListView);
 
+    d->finishSearch();
+
     // NOTE:
     // We need delete items in QList before clear QList to avoid *MEMORY LEAK* .
-    qDeleteAll(d->listItems->begin(), d->listItems->end());
-    d->listItems->clear();
-    d->renderItems->clear();
+    qDeleteAll(d->itemSource->items.begin(), d->itemSource->items.end());
+    d->itemSource->items.clear();
+
+    if (d->isItemMode()) {
+        d->resetRows();
+    }
 }
 
 /*!
@@ -363,12 +701,24 @@ void DSimpleListView::addSelections(QList<DSimpleListItem*> items, bool recordLa
 {
     D_D(DSimpleListView);
 
-    // Add item to selection list.
-    d->selectionItems->append(items);
+    if (d->isItemMode()) {
+        addSelectionRows(d->rowsOf(items), recordLastSelection);
+    }
+}
+
+/*!
+ * \~chinese \brief 添加行到选择项，行为数据源中的索引
+ */
+void DSimpleListView::addSelectionRows(QList<int> rows, bool recordLastSelection)
+{
+    D_D(DSimpleListView);
+
+    // Add row to selection list.
+    d->selectionRows.append(rows);
 
-    // Record last selection item to make selected operation continuously.
-    if (recordLastSelection && d->selectionItems->count() > 0) {
-        d->lastSelectItem = d->selectionItems->last();
+    // Record last selection row to make selected operation continuously.
+    if (recordLastSelection && d->selectionRows.count() > 0) {
+        d->lastSelectRow = d->selectionRows.last();
     }
 }
 
@@ -380,10 +730,10 @@ void DSimpleListView::clearSelections(bool clearLastSelection)
     D_D(DSimpleListView);
 
     // Clear selection list.
-    d->selectionItems->clear();
+    d->selectionRows.clear();
 
     if (clearLastSelection) {
-        d->lastSelectItem = NULL;
+        d->lastSelectRow = -1;
     }
 }
 
@@ -394,72 +744,104 @@ QList<DSimpleListItem*> DSimpleListView::getSelections()
 {
     D_D(DSimpleListView);
 
-    return *d->selectionItems;
+    if (!d->isItemMode()) {
+        return QList<DSimpleListItem*>();
+    }
+
+    return d->itemsAt(d->selectionRows);
+}
+
+/*!
+ * \~chinese \brief 获取所有选择行，行为数据源中的索引
+ */
+QList<int> DSimpleListView::getSelectionRows()
+{
+    D_D(DSimpleListView);
+
+    return d->selectionRows;
 }
 
 /*!
  * \~chinese \brief 刷新所有项
+ * \~chinese \brief 设置了键算法时，键相同的行保持原来的顺序，排序列的键没有改变且没有新项时不重新排序
  */
 void DSimpleListView::refreshItems(QList<DSimpleListItem*> items)
 {
     D_D(DSimpleListView);
 
-    // Init.
-    QList<DSimpleListItem*> *newSelectionItems = new QList<DSimpleListItem*>();
-    DSimpleListItem *newLastSelectionItem = NULL;
-    DSimpleListItem *newLastHoverItem = NULL;
-
-    // Save selection items and last selection item.
-    for (DSimpleListItem *item:items) {
-        for (DSimpleListItem *selectionItem:*d->selectionItems) {
-            if (item->sameAs(selectionItem)) {
-                newSelectionItems->append(item);
-                break;
-            }
-        }
+    if (!d->isItemMode()) {
+        return;
     }
 
-    if (d->lastSelectItem != NULL) {
+    d->finishSearch();
+
+    if (d->keyAlgorithm != NULL) {
+        // Match old and new items by key, the previous row order is kept.
+        // Sort keys of old items are cached before deleting them, unchanged rows don't need sorting.
+        QVector<QString> oldKeys = d->getSourceKeys();
+        d->cacheSortKeys();
+
+        qDeleteAll(d->itemSource->items.begin(), d->itemSource->items.end());
+        d->itemSource->items = items;
+
+        d->remapRows(oldKeys, d->getSourceKeys());
+    } else {
+        // Save selection items and last selection item.
+        QList<DSimpleListItem*> newSelectionItems;
+        DSimpleListItem *newLastSelectionItem = NULL;
+        DSimpleListItem *newLastHoverItem = NULL;
+        QList<DSimpleListItem*> selectionItems = d->itemsAt(d->selectionRows);
+        DSimpleListItem *lastSelectItem = d->itemAt(d->lastSelectRow);
+        DSimpleListItem *lastHoverItem = d->itemAt(d->lastHoverRow);
+
         for (DSimpleListItem *item:items) {
-            if (item->sameAs(d->lastSelectItem)) {
-                newLastSelectionItem = item;
-                break;
+            for (DSimpleListItem *selectionItem:selectionItems) {
+                if (item->sameAs(selectionItem)) {
+                    newSelectionItems.append(item);
+                    break;
+                }
             }
         }
-    }
 
-    if (d->lastHoverItem != NULL) {
-        for (DSimpleListItem *item:items) {
-            if (item->sameAs(d->lastHoverItem)) {
-                newLastHoverItem = item;
-                break;
+        if (lastSelectItem != NULL) {
+            for (DSimpleListItem *item:items) {
+                if (item->sameAs(lastSelectItem)) {
+                    newLastSelectionItem = item;
+                    break;
+                }
             }
         }
-    }
-    d->lastHoverItem = NULL;
 
-    // Update items.
-    clearItems();
-    d->listItems->append(items);
-    QList<DSimpleListItem*> searchItems = d->getSearchItems(items);
-    d->renderItems->append(searchItems);
+        if (lastHoverItem != NULL) {
+            for (DSimpleListItem *item:items) {
+                if (item->sameAs(lastHoverItem)) {
+                    newLastHoverItem = item;
+                    break;
+                }
+            }
+        }
 
-    // Sort once if default sort column hasn't init.
-    if (d->defaultSortingColumn != -1) {
-        d->sortItemsByColumn(d->defaultSortingColumn, d->defaultSortingOrder);
-    }
+        // Update items.
+        clearItems();
+        d->itemSource->items = items;
+        d->renderRows = d->getSearchRows(d->getAllRows());
 
-    // Restore selection items and last selection item.
-    clearSelections();
-    addSelections(*newSelectionItems, false);
-    d->lastSelectItem = newLastSelectionItem;
-    d->lastHoverItem = newLastHoverItem;
+        // Sort once if default sort column hasn't init.
+        if (d->defaultSortingColumn != -1) {
+            d->sortRowsByColumn(d->defaultSortingColumn, d->defaultSortingOrder);
+        }
+
+        // Restore selection items and last selection item.
+        addSelections(newSelectionItems, false);
+        d->lastSelectRow = items.indexOf(newLastSelectionItem);
+        d->lastHoverRow = items.indexOf(newLastHoverItem);
+    }
 
     // Keep scroll position.
     d->renderOffset = adjustRenderOffset(d->renderOffset);
 
     // Render.
-    repaint();
+    update();
 }
 
 /*!
@@ -469,20 +851,26 @@ void DSimpleListView::search(QString content)
 {
     D_D(DSimpleListView);
 
-    if (content == "" && d->searchContent != content) {
-        d->searchContent = content;
+    d->cancelSearch();
 
-        d->renderItems->clear();
-        d->renderItems->append(*d->listItems);
-    } else {
-        d->searchContent = content;
+    // Rows matching extended content always match the shorter content, only narrow rows of last search.
+    // Search algorithm of items never promised this, so items are always searched from all rows.
+    bool narrow = !d->isItemMode() && content.startsWith(d->searchContent);
+    QVector<int> rows = narrow ? d->renderRows : d->getAllRows();
 
-        QList<DSimpleListItem*> searchItems = d->getSearchItems(*d->listItems);
-        d->renderItems->clear();
-        d->renderItems->append(searchItems);
-    }
+    if (content == "" || rows.count() < CONCURRENT_SEARCH_MIN_ROWS || !d->source->canMatchConcurrently()) {
+        if (content != "") {
+            rows = matchRows(d->source, rows, content, QSharedPointer<QAtomicInt>());
+        }
 
-    repaint();
+        d->applySearchRows(content, rows);
+    } else {
+        // Keep rendering rows of last search until search finished.
+        d->pendingSearchContent = content;
+        d->searchCanceled.reset(new QAtomicInt(0));
+        d->searchPending = true;
+        d->searchWatcher->setFuture(QtConcurrent::run(matchRows, d->source, rows, content, d->searchCanceled));
+    }
 }
 
 /*!
@@ -518,13 +906,13 @@ void DSimpleListView::selectAllItems()
 
         // Select all items.
         clearSelections();
-        addSelections(*d->renderItems);
+        addSelectionRows(d->renderRows.toList());
 
         // Scroll to top.
         d->renderOffset = d->getTopRenderOffset();
 
         // Repaint.
-        repaint();
+        update();
     }
 
 }
@@ -542,15 +930,15 @@ void DSimpleListView::selectFirstItem()
     // Select first item.
     clearSelections();
 
-    QList<DSimpleListItem*> items = QList<DSimpleListItem*>();
-    items << d->renderItems->first();
-    addSelections(items);
+    QList<int> rows = QList<int>();
+    rows << d->renderRows.first();
+    addSelectionRows(rows);
 
     // Scroll to top.
     d->renderOffset = d->getTopRenderOffset();
 
     // Repaint.
-    repaint();
+    update();
 }
 
 /*!
@@ -566,15 +954,15 @@ void DSimpleListView::selectLastItem()
     // Select last item.
     clearSelections();
 
-    QList<DSimpleListItem*> items = QList<DSimpleListItem*>();
-    items << d->renderItems->last();
-    addSelections(items);
+    QList<int> rows = QList<int>();
+    rows << d->renderRows.last();
+    addSelectionRows(rows);
 
     // Scroll to bottom.
     d->renderOffset = getBottomRenderOffset();
 
     // Repaint.
-    repaint();
+    update();
 }
 
 /*!
@@ -626,20 +1014,20 @@ void DSimpleListView::shiftSelectToEnd()
 
     if (!d->isSingleSelect) {
         // Select last item if nothing selected yet.
-        if (d->selectionItems->empty()) {
+        if (d->selectionRows.empty()) {
             selectLastItem();
         }
         // Select items from last selected item to last item.
         else {
             // Found last selected index and do select operation.
-            int lastSelectionIndex = d->renderItems->indexOf(d->lastSelectItem);
-            shiftSelectItemsWithBound(lastSelectionIndex, d->renderItems->count() - 1);
+            int lastSelectionIndex = d->renderRows.indexOf(d->lastSelectRow);
+            shiftSelectItemsWithBound(lastSelectionIndex, d->renderRows.count() - 1);
 
             // Scroll to bottom.
             d->renderOffset = getBottomRenderOffset();
 
             // Repaint.
-            repaint();
+            update();
         }
     }
 
@@ -654,20 +1042,20 @@ void DSimpleListView::shiftSelectToHome()
 
     if (!d->isSingleSelect) {
         // Select first item if nothing selected yet.
-        if (d->selectionItems->empty()) {
+        if (d->selectionRows.empty()) {
             selectFirstItem();
         }
         // Select items from last selected item to first item.
         else {
             // Found last selected index and do select operation.
-            int lastSelectionIndex = d->renderItems->indexOf(d->lastSelectItem);
+            int lastSelectionIndex = d->renderRows.indexOf(d->lastSelectRow);
             shiftSelectItemsWithBound(0, lastSelectionIndex);
 
             // Scroll to top.
             d->renderOffset = d->getTopRenderOffset();
 
             // Repaint.
-            repaint();
+            update();
         }
     }
 
@@ -723,7 +1111,7 @@ void DSimpleListView::ctrlScrollPageUp()
 
     d->renderOffset = adjustRenderOffset(d->renderOffset - getScrollAreaHeight());
 
-    repaint();
+    update();
 }
 
 void DSimpleListView::ctrlScrollPageDown()
@@ -732,7 +1120,7 @@ void DSimpleListView::ctrlScrollPageDown()
 
     d->renderOffset = adjustRenderOffset(d->renderOffset + getScrollAreaHeight());
 
-    repaint();
+    update();
 }
 
 void DSimpleListView::ctrlScrollToHome()
@@ -741,7 +1129,7 @@ void DSimpleListView::ctrlScrollToHome()
 
     d->renderOffset = d->getTopRenderOffset();
 
-    repaint();
+    update();
 }
 
 void DSimpleListView::ctrlScrollToEnd()
@@ -750,16 +1138,16 @@ void DSimpleListView::ctrlScrollToEnd()
 
     d->renderOffset = getBottomRenderOffset();
 
-    repaint();
+    update();
 }
 
 void DSimpleListView::leaveEvent(QEvent * event)
 {
     D_D(DSimpleListView);
 
-    d->lastHoverItem.clear();
-    d->drawHoverItem.clear();
-    d->mouseHoverItem.clear();
+    d->lastHoverRow = -1;
+    d->drawHoverRow = -1;
+    d->mouseHoverRow = -1;
 
     hideScrollbar();
 
@@ -774,7 +1162,7 @@ void DSimpleListView::hideScrollbar()
     d->mouseAtScrollArea = false;
     d->oldRenderOffset = d->renderOffset;
 
-    repaint();
+    update();
 }
 
 bool DSimpleListView::eventFilter(QObject *, QEvent *)
@@ -844,12 +1232,12 @@ void DSimpleListView::mouseMoveEvent(QMouseEvent *mouseEvent)
         int barHeight = getScrollbarHeight();
         d->renderOffset = adjustRenderOffset((mouseEvent->y() - barHeight / 2 - d->titleHeight) / (getScrollAreaHeight() * 1.0) * d->getItemsTotalHeight());
 
-        repaint();
+        update();
     }
     // Update scrollbar status with mouse position.
     else if (isMouseAtScrollArea(mouseEvent->x()) != d->mouseAtScrollArea) {
         d->mouseAtScrollArea = isMouseAtScrollArea(mouseEvent->x());
-        repaint();
+        update();
     }
     // Otherwise to check titlebar arrow status.
     else {
@@ -858,7 +1246,7 @@ void DSimpleListView::mouseMoveEvent(QMouseEvent *mouseEvent)
         if (atTitleArea) {
             int hoverColumn = -1;
 
-            if (d->sortingAlgorithms->count() != 0 && d->sortingAlgorithms->count() == d->columnTitles.count() && d->sortingOrderes->count() == d->columnTitles.count()) {
+            if (d->canSort()) {
                 // Calculate title widths;
                 QList<int> renderWidths = getRenderWidths();
 
@@ -882,14 +1270,14 @@ void DSimpleListView::mouseMoveEvent(QMouseEvent *mouseEvent)
             if (hoverColumn != d->titleHoverColumn) {
                 d->titleHoverColumn = hoverColumn;
 
-                repaint();
+                update();
             }
         } else {
             int hoverItemIndex = (d->renderOffset + mouseEvent->y() - d->titleHeight) / d->rowHeight;
 
             // NOTE: hoverItemIndex may be less than 0, we need check index here.
-            if (hoverItemIndex >= 0 && hoverItemIndex < (*d->renderItems).length()) {
-                DSimpleListItem *item = (*d->renderItems)[hoverItemIndex];
+            if (hoverItemIndex >= 0 && hoverItemIndex < d->renderRows.count()) {
+                int row = d->renderRows[hoverItemIndex];
 
                 QList<int> renderWidths = getRenderWidths();
 
@@ -907,23 +1295,34 @@ void DSimpleListView::mouseMoveEvent(QMouseEvent *mouseEvent)
                     columnCounter++;
                 }
 
-                if (d->drawHoverItem == NULL || !item->sameAs(d->drawHoverItem)) {
-                    d->drawHoverItem = item;
+                if (row != d->drawHoverRow) {
+                    // Only the rows losing and gaining hover need repaint.
+                    int oldHoverItemIndex = d->renderRows.indexOf(d->drawHoverRow);
+                    if (oldHoverItemIndex != -1) {
+                        update(0, d->titleHeight + oldHoverItemIndex * d->rowHeight - d->renderOffset, rect().width(), d->rowHeight);
+                    }
+
+                    d->drawHoverRow = row;
 
-                    repaint();
+                    update(0, d->titleHeight + hoverItemIndex * d->rowHeight - d->renderOffset, rect().width(), d->rowHeight);
                 }
 
                 // Emit mouseHoverChanged signal.
-                mouseHoverChanged(d->mouseHoverItem, item, columnCounter,
-                                  QPoint(mouseEvent->x() - columnRenderX,
-                                         d->renderOffset + mouseEvent->y() - hoverItemIndex * d->rowHeight));
-                d->mouseHoverItem = item;
+                QPoint hoverPos(mouseEvent->x() - columnRenderX, d->renderOffset + mouseEvent->y() - hoverItemIndex * d->rowHeight);
+                if (d->isItemMode()) {
+                    mouseHoverChanged(d->itemAt(d->mouseHoverRow), d->itemAt(row), columnCounter, hoverPos);
+                }
+                mouseHoverRowChanged(d->mouseHoverRow, row, columnCounter, hoverPos);
+                d->mouseHoverRow = row;
 
-                if (d->lastHoverItem == NULL || !item->sameAs(d->lastHoverItem) || columnCounter != d->lastHoverColumnIndex) {
-                    d->lastHoverItem = item;
+                if (row != d->lastHoverRow || columnCounter != d->lastHoverColumnIndex) {
+                    d->lastHoverRow = row;
                     d->lastHoverColumnIndex = columnCounter;
 
-                    changeHoverItem(this->mapToGlobal(mouseEvent->pos()), d->lastHoverItem, columnCounter);
+                    if (d->isItemMode()) {
+                        changeHoverItem(this->mapToGlobal(mouseEvent->pos()), d->itemAt(row), columnCounter);
+                    }
+                    changeHoverRow(this->mapToGlobal(mouseEvent->pos()), row, columnCounter);
                 }
             }
         }
@@ -942,7 +1341,7 @@ void DSimpleListView::mousePressEvent(QMouseEvent *mouseEvent)
     // Sort items with column's sorting algorithms when click on title area.
     if (atTitleArea) {
         if (mouseEvent->button() == Qt::LeftButton) {
-            if (d->sortingAlgorithms->count() != 0 && d->sortingAlgorithms->count() == d->columnTitles.count() && d->sortingOrderes->count() == d->columnTitles.count()) {
+            if (d->canSort()) {
                 // Calculate title widths;
                 QList<int> renderWidths = getRenderWidths();
 
@@ -965,13 +1364,13 @@ void DSimpleListView::mousePressEvent(QMouseEvent *mouseEvent)
 
                             changeSortingStatus(d->defaultSortingColumn, d->defaultSortingOrder);
 
-                            d->sortItemsByColumn(columnCounter, (*d->sortingOrderes)[columnCounter]);
+                            d->sortRowsByColumn(columnCounter, (*d->sortingOrderes)[columnCounter]);
 
                             if (columnCounter != d->titlePressColumn) {
                                 d->titlePressColumn = columnCounter;
                             }
 
-                            repaint();
+                            update();
                             break;
                         }
 
@@ -1001,7 +1400,7 @@ void DSimpleListView::mousePressEvent(QMouseEvent *mouseEvent)
 
                            changeColumnVisible(i, columnVisibles[i], columnVisibles);
 
-                           repaint();
+                           update();
                        });
 
                         menu->addAction(action);
@@ -1024,37 +1423,37 @@ void DSimpleListView::mousePressEvent(QMouseEvent *mouseEvent)
         // Scroll if click out of scrollbar area.
         else {
             d->renderOffset = adjustRenderOffset((mouseEvent->y() - barHeight / 2 - d->titleHeight) / (getScrollAreaHeight() * 1.0) * d->getItemsTotalHeight());
-            repaint();
+            update();
         }
     }
     // Select items.
     else {
         int pressItemIndex = (d->renderOffset + mouseEvent->y() - d->titleHeight) / d->rowHeight;
 
-        if (pressItemIndex >= d->renderItems->count()) {
+        if (pressItemIndex >= d->renderRows.count()) {
             if (!d->isKeepSelectWhenClickBlank) {
                 clearSelections();
             }
 
-            repaint();
+            update();
         } else {
             if (mouseEvent->button() == Qt::LeftButton) {
-                if (pressItemIndex < d->renderItems->count()) {
+                if (pressItemIndex < d->renderRows.count()) {
                     // Scattered selection of items when press ctrl modifier.
                     if (!d->isSingleSelect && mouseEvent->modifiers() == Qt::ControlModifier) {
-                        DSimpleListItem *item = (*d->renderItems)[pressItemIndex];
+                        int row = d->renderRows[pressItemIndex];
 
-                        if (d->selectionItems->contains(item)) {
-                            d->selectionItems->removeOne(item);
+                        if (d->selectionRows.contains(row)) {
+                            d->selectionRows.removeOne(row);
                         } else {
-                            QList<DSimpleListItem*> items = QList<DSimpleListItem*>();
-                            items << item;
-                            addSelections(items);
+                            QList<int> rows = QList<int>();
+                            rows << row;
+                            addSelectionRows(rows);
                         }
                     }
                     // Continuous selection of items when press shift modifier.
-                    else if (!d->isSingleSelect && (mouseEvent->modifiers() == Qt::ShiftModifier) && !d->selectionItems->empty()) {
-                        int lastSelectionIndex = d->renderItems->indexOf(d->lastSelectItem);
+                    else if (!d->isSingleSelect && (mouseEvent->modifiers() == Qt::ShiftModifier) && !d->selectionRows.empty()) {
+                        int lastSelectionIndex = d->renderRows.indexOf(d->lastSelectRow);
                         int selectionStartIndex = std::min(pressItemIndex, lastSelectionIndex);
                         int selectionEndIndex = std::max(pressItemIndex, lastSelectionIndex);
 
@@ -1064,9 +1463,9 @@ void DSimpleListView::mousePressEvent(QMouseEvent *mouseEvent)
                     else {
                         clearSelections();
 
-                        QList<DSimpleListItem*> items = QList<DSimpleListItem*>();
-                        items << (*d->renderItems)[pressItemIndex];
-                        addSelections(items);
+                        QList<int> rows = QList<int>();
+                        rows << d->renderRows[pressItemIndex];
+                        addSelectionRows(rows);
                     }
 
                     // Emit mousePressChanged signal.
@@ -1084,36 +1483,33 @@ void DSimpleListView::mousePressEvent(QMouseEvent *mouseEvent)
 
                         columnCounter++;
                     }
-                    mousePressChanged((*d->renderItems)[pressItemIndex], columnCounter,
-                                      QPoint(mouseEvent->x() - columnRenderX,
-                                             d->renderOffset + mouseEvent->y() - pressItemIndex * d->rowHeight));
+                    QPoint pressPos(mouseEvent->x() - columnRenderX, d->renderOffset + mouseEvent->y() - pressItemIndex * d->rowHeight);
+                    if (d->isItemMode()) {
+                        mousePressChanged(d->itemAt(d->renderRows[pressItemIndex]), columnCounter, pressPos);
+                    }
+                    mousePressRowChanged(d->renderRows[pressItemIndex], columnCounter, pressPos);
 
-                    repaint();
+                    update();
                 }
             } else if (mouseEvent->button() == Qt::RightButton) {
-                DSimpleListItem *pressItem = (*d->renderItems)[pressItemIndex];
-                bool pressInSelectionArea = false;
-
-                for (DSimpleListItem *item : *d->selectionItems) {
-                    if (item == pressItem) {
-                        pressInSelectionArea = true;
-
-                        break;
-                    }
-                }
+                int pressRow = d->renderRows[pressItemIndex];
+                bool pressInSelectionArea = d->selectionRows.contains(pressRow);
 
-                if (!pressInSelectionArea && pressItemIndex < d->renderItems->length()) {
+                if (!pressInSelectionArea && pressItemIndex < d->renderRows.count()) {
                     clearSelections();
 
-                    QList<DSimpleListItem*> items = QList<DSimpleListItem*>();
-                    items << (*d->renderItems)[pressItemIndex];
-                    addSelections(items);
+                    QList<int> rows = QList<int>();
+                    rows << pressRow;
+                    addSelectionRows(rows);
 
-                    repaint();
+                    update();
                 }
 
-                if (d->selectionItems->length() > 0) {
-                    rightClickItems(this->mapToGlobal(mouseEvent->pos()), *d->selectionItems);
+                if (d->selectionRows.length() > 0) {
+                    if (d->isItemMode()) {
+                        rightClickItems(this->mapToGlobal(mouseEvent->pos()), d->itemsAt(d->selectionRows));
+                    }
+                    rightClickRows(this->mapToGlobal(mouseEvent->pos()), d->selectionRows);
                 }
             }
         }
@@ -1128,18 +1524,18 @@ void DSimpleListView::mouseReleaseEvent(QMouseEvent *mouseEvent)
         // Reset mouseDragScrollbar.
         d->mouseDragScrollbar = false;
 
-        repaint();
+        update();
     } else {
         if (d->titlePressColumn != -1) {
             d->titlePressColumn = -1;
-            repaint();
+            update();
         }
     }
 
     // Emit mouseReleaseChanged signal.
     int releaseItemIndex = (d->renderOffset + mouseEvent->y() - d->titleHeight) / d->rowHeight;
 
-    if (releaseItemIndex >= 0 && releaseItemIndex < (*d->renderItems).length()) {
+    if (releaseItemIndex >= 0 && releaseItemIndex < d->renderRows.count()) {
         QList<int> renderWidths = getRenderWidths();
         int columnCounter = 0;
         int columnRenderX = 0;
@@ -1154,9 +1550,11 @@ void DSimpleListView::mouseReleaseEvent(QMouseEvent *mouseEvent)
 
             columnCounter++;
         }
-        mouseReleaseChanged((*d->renderItems)[releaseItemIndex], columnCounter,
-                            QPoint(mouseEvent->x() - columnRenderX,
-                                   d->renderOffset + mouseEvent->y() - releaseItemIndex * d->rowHeight));
+        QPoint releasePos(mouseEvent->x() - columnRenderX, d->renderOffset + mouseEvent->y() - releaseItemIndex * d->rowHeight);
+        if (d->isItemMode()) {
+            mouseReleaseChanged(d->itemAt(d->renderRows[releaseItemIndex]), columnCounter, releasePos);
+        }
+        mouseReleaseRowChanged(d->renderRows[releaseItemIndex], columnCounter, releasePos);
     }
 }
 
@@ -1171,13 +1569,13 @@ void DSimpleListView::wheelEvent(QWheelEvent *event)
         qreal scrollStep = event->angleDelta().y() / 120.0;
         d->renderOffset = adjustRenderOffset(d->renderOffset - scrollStep * d->scrollUnit);
 
-        repaint();
+        update();
     }
 
     event->accept();
 }
 
-void DSimpleListView::paintEvent(QPaintEvent *)
+void DSimpleListView::paintEvent(QPaintEvent *event)
 {
     D_D(DSimpleListView);
 
@@ -1191,9 +1589,20 @@ void DSimpleListView::paintEvent(QPaintEvent *)
     painter.setRenderHint(QPainter::Antialiasing, true);
     painter.setOpacity(0.05);
 
-    int penWidth = 1;
-    QPainterPath framePath;
-    framePath.addRoundedRect(QRect(rect().x() + penWidth, rect().y() + penWidth, rect().width() - penWidth * 2, rect().height() - penWidth * 2), d->clipRadius, d->clipRadius);
+    // Rebuild clip paths only when size changed.
+    if (d->framePathSize != size()) {
+        int penWidth = 1;
+        d->framePath = QPainterPath();
+        d->framePath.addRoundedRect(QRect(rect().x() + penWidth, rect().y() + penWidth, rect().width() - penWidth * 2, rect().height() - penWidth * 2), d->clipRadius, d->clipRadius);
+
+        QPainterPath scrollAreaPath;
+        scrollAreaPath.addRect(QRectF(rect().x(), rect().y() + d->titleHeight, rect().width(), getScrollAreaHeight()));
+        d->contentPath = d->framePath.intersected(scrollAreaPath);
+
+        d->framePathSize = size();
+    }
+
+    const QPainterPath &framePath = d->framePath;
     painter.setClipPath(framePath);
 
     // Draw title.
@@ -1205,18 +1614,17 @@ void DSimpleListView::paintEvent(QPaintEvent *)
     }
 
     int renderY = 0;
-    int renderHeight = 0;
-    if (d->titleHeight > 0) {
+    if (d->titleHeight > 0 && event->rect().top() < d->titleHeight) {
+        QFont font = painter.font() ;
+        font.setPointSize(titleSize);
+        painter.setFont(font);
+
         int columnCounter = 0;
         int columnRenderX = 0;
         for (int renderWidth:renderWidths) {
             if (renderWidth > 0) {
                 painter.setOpacity(1);
 
-                QFont font = painter.font() ;
-                font.setPointSize(titleSize);
-                painter.setFont(font);
-
                 painter.setPen(QPen(QColor(titleColor)));
                 painter.drawText(QRect(columnRenderX + d->titlePadding, 0, renderWidth, d->titleHeight), Qt::AlignVCenter | Qt::AlignLeft, d->columnTitles[columnCounter]);
 
@@ -1256,9 +1664,10 @@ void DSimpleListView::paintEvent(QPaintEvent *)
             }
             columnCounter++;
         }
+    }
 
+    if (d->titleHeight > 0) {
         renderY += d->titleHeight;
-        renderHeight += d->titleHeight;
     }
 
     // Draw background.
@@ -1267,27 +1676,41 @@ void DSimpleListView::paintEvent(QPaintEvent *)
     backgroundPath.addRect(QRectF(rect().x(), rect().y() + d->titleHeight, rect().width(), rect().height() - d->titleHeight));
     painter.fillPath(backgroundPath, QColor(backgroundColor));
 
-    // Draw context.
-    QPainterPath scrollAreaPath;
-    scrollAreaPath.addRect(QRectF(rect().x(), rect().y() + d->titleHeight, rect().width(), getScrollAreaHeight()));
+    // Draw context, only visit rows intersecting the exposed rect.
+    const QRect &exposedRect = event->rect().intersected(QRect(0, renderY, rect().width(), getScrollAreaHeight()));
+
+    if (!exposedRect.isEmpty() && !d->renderRows.isEmpty()) {
+        int firstRow = std::max(0, (d->renderOffset + exposedRect.top() - renderY) / d->rowHeight);
+        int lastRow = std::min(d->renderRows.count() - 1, (d->renderOffset + exposedRect.bottom() - renderY) / d->rowHeight);
+
+        // Look up selections in a set, select all makes the selection as big as the list.
+        QSet<int> selections;
+        if (lastRow >= firstRow) {
+            selections.reserve(d->selectionRows.count());
+
+            for (int row:d->selectionRows) {
+                selections.insert(row);
+            }
+        }
+
+        for (int rowCounter = firstRow; rowCounter <= lastRow; rowCounter++) {
+            int row = d->renderRows[rowCounter];
+            QRect itemRect(0, renderY + rowCounter * d->rowHeight - d->renderOffset, rect().width(), d->rowHeight);
 
-    int rowCounter = 0;
-    for (DSimpleListItem *item:*d->renderItems) {
-        if (rowCounter >= d->renderOffset / d->rowHeight) {
             // Clip item rect.
-            QPainterPath itemPath;
-            itemPath.addRect(QRect(0, renderY + rowCounter * d->rowHeight - d->renderOffset, rect().width(), d->rowHeight));
-            painter.setClipPath((framePath.intersected(scrollAreaPath)).intersected(itemPath));
+            painter.setClipPath(d->contentPath);
+            painter.setClipRect(itemRect, Qt::IntersectClip);
 
             // Draw item backround.
-            bool isSelect = d->selectionItems->contains(item);
-            bool isHover = d->drawHoverItem != NULL && item->sameAs(d->drawHoverItem);
+            bool isSelect = selections.contains(row);
+            bool isHover = row == d->drawHoverRow;
             painter.save();
-            item->drawBackground(QRect(0, renderY + rowCounter * d->rowHeight - d->renderOffset, rect().width(), d->rowHeight),
-                                 &painter,
-                                 rowCounter,
-                                 isSelect,
-                                 isHover);
+            d->delegate->drawBackground(itemRect,
+                                        &painter,
+                                        row,
+                                        rowCounter,
+                                        isSelect,
+                                        isHover);
             painter.restore();
 
             // Draw item foreground.
@@ -1296,34 +1719,27 @@ void DSimpleListView::paintEvent(QPaintEvent *)
             for (int renderWidth:renderWidths) {
                 if (renderWidth > 0) {
                     painter.save();
-                    item->drawForeground(QRect(columnRenderX, renderY + rowCounter * d->rowHeight - d->renderOffset, renderWidth, d->rowHeight),
-                                         &painter,
-                                         columnCounter,
-                                         rowCounter,
-                                         isSelect,
-                                         isHover);
+                    d->delegate->drawForeground(QRect(columnRenderX, itemRect.y(), renderWidth, d->rowHeight),
+                                                &painter,
+                                                columnCounter,
+                                                row,
+                                                rowCounter,
+                                                isSelect,
+                                                isHover);
                     painter.restore();
 
                     columnRenderX += renderWidth;
                 }
                 columnCounter++;
             }
-
-            renderHeight += d->rowHeight;
-
-            if (renderHeight > rect().height()) {
-                break;
-            }
         }
-
-        rowCounter++;
     }
 
     // Keep clip area.
     painter.setClipPath(framePath);
 
     // Draw search tooltip.
-    if (d->searchContent != "" && d->renderItems->size() == 0) {
+    if (d->searchContent != "" && d->renderRows.size() == 0) {
         painter.setOpacity(1);
         painter.setPen(QPen(QColor(searchColor)));
 
@@ -1409,26 +1825,26 @@ void DSimpleListView::selectNextItemWithOffset(int scrollOffset)
     // Record old render offset to control scrollbar whether display.
     d->oldRenderOffset = d->renderOffset;
 
-    if (d->selectionItems->empty()) {
+    if (d->selectionRows.empty()) {
         selectFirstItem();
     } else {
         int lastIndex = 0;
-        for (DSimpleListItem *item:*d->selectionItems) {
-            int index = d->renderItems->indexOf(item);
+        for (int row:d->selectionRows) {
+            int index = d->renderRows.indexOf(row);
             if (index > lastIndex) {
                 lastIndex = index;
             }
         }
 
         if (lastIndex != -1) {
-            lastIndex = std::min(d->renderItems->count() - 1, lastIndex + scrollOffset);
+            lastIndex = std::min(d->renderRows.count() - 1, lastIndex + scrollOffset);
 
             clearSelections(false);
 
-            QList<DSimpleListItem*> items = QList<DSimpleListItem*>();
-            items << (*d->renderItems)[lastIndex];
+            QList<int> rows = QList<int>();
+            rows << d->renderRows[lastIndex];
 
-            addSelections(items);
+            addSelectionRows(rows);
 
             int itemIndex = lastIndex + 1;
             int itemOffset = adjustRenderOffset(itemIndex * d->rowHeight - rect().height() + d->titleHeight);
@@ -1436,7 +1852,7 @@ void DSimpleListView::selectNextItemWithOffset(int scrollOffset)
                 d->renderOffset = itemOffset;
             }
 
-            repaint();
+            update();
         }
     }
 }
@@ -1448,12 +1864,12 @@ void DSimpleListView::selectPrevItemWithOffset(int scrollOffset)
     // Record old render offset to control scrollbar whether display.
     d->oldRenderOffset = d->renderOffset;
 
-    if (d->selectionItems->empty()) {
+    if (d->selectionRows.empty()) {
         selectFirstItem();
     } else {
-        int firstIndex = d->renderItems->count();
-        for (DSimpleListItem *item:*d->selectionItems) {
-            int index = d->renderItems->indexOf(item);
+        int firstIndex = d->renderRows.count();
+        for (int row:d->selectionRows) {
+            int index = d->renderRows.indexOf(row);
             if (index < firstIndex) {
                 firstIndex = index;
             }
@@ -1464,10 +1880,10 @@ void DSimpleListView::selectPrevItemWithOffset(int scrollOffset)
 
             clearSelections();
 
-            QList<DSimpleListItem*> items = QList<DSimpleListItem*>();
-            items << (*d->renderItems)[firstIndex];
+            QList<int> rows = QList<int>();
+            rows << d->renderRows[firstIndex];
 
-            addSelections(items);
+            addSelectionRows(rows);
 
             int itemIndex = firstIndex - 1;
             int itemOffset = adjustRenderOffset(itemIndex * d->rowHeight + d->titleHeight);
@@ -1475,7 +1891,7 @@ void DSimpleListView::selectPrevItemWithOffset(int scrollOffset)
                 d->renderOffset = itemOffset;
             }
 
-            repaint();
+            update();
         }
     }
 }
@@ -1487,11 +1903,11 @@ void DSimpleListView::shiftSelectItemsWithBound(int selectionStartIndex, int sel
     // Note: Shift operation always selection bound from last selection index to current index.
     // So we don't need *clear* lastSelectionIndex for keep shift + button is right logic.
     clearSelections(false);
-    QList<DSimpleListItem*> items = QList<DSimpleListItem*>();
+    QList<int> rows = QList<int>();
     int index = 0;
-    for (DSimpleListItem *item:*d->renderItems) {
+    for (int row:d->renderRows) {
         if (index >= selectionStartIndex && index <= selectionEndIndex) {
-            items << item;
+            rows << row;
         }
 
         index++;
@@ -1499,7 +1915,7 @@ void DSimpleListView::shiftSelectItemsWithBound(int selectionStartIndex, int sel
 
     // Note: Shift operation always selection bound from last selection index to current index.
     // So we don't need *record* lastSelectionIndex for keep shift + button is right logic.
-    addSelections(items, false);
+    addSelectionRows(rows, false);
 }
 
 void DSimpleListView::shiftSelectPrevItemWithOffset(int scrollOffset)
@@ -1509,13 +1925,13 @@ void DSimpleListView::shiftSelectPrevItemWithOffset(int scrollOffset)
     // Record old render offset to control scrollbar whether display.
     d->oldRenderOffset = d->renderOffset;
 
-    if (d->selectionItems->empty()) {
+    if (d->selectionRows.empty()) {
         selectFirstItem();
     } else {
-        int firstIndex = d->renderItems->count();
+        int firstIndex = d->renderRows.count();
         int lastIndex = 0;
-        for (DSimpleListItem *item:*d->selectionItems) {
-            int index = d->renderItems->indexOf(item);
+        for (int row:d->selectionRows) {
+            int index = d->renderRows.indexOf(row);
 
             if (index < firstIndex) {
                 firstIndex = index;
@@ -1527,7 +1943,7 @@ void DSimpleListView::shiftSelectPrevItemWithOffset(int scrollOffset)
         }
 
         if (firstIndex != -1) {
-            int lastSelectionIndex = d->renderItems->indexOf(d->lastSelectItem);
+            int lastSelectionIndex = d->renderRows.indexOf(d->lastSelectRow);
             int selectionStartIndex, selectionEndIndex;
 
             if (lastIndex == lastSelectionIndex) {
@@ -1544,7 +1960,7 @@ void DSimpleListView::shiftSelectPrevItemWithOffset(int scrollOffset)
                 d->renderOffset = adjustRenderOffset((selectionStartIndex - 1) * d->rowHeight + d->titleHeight);
             }
 
-            repaint();
+            update();
         }
     }
 }
@@ -1556,13 +1972,13 @@ void DSimpleListView::shiftSelectNextItemWithOffset(int scrollOffset)
     // Record old render offset to control scrollbar whether display.
     d->oldRenderOffset = d->renderOffset;
 
-    if (d->selectionItems->empty()) {
+    if (d->selectionRows.empty()) {
         selectFirstItem();
     } else {
-        int firstIndex = d->renderItems->count();
+        int firstIndex = d->renderRows.count();
         int lastIndex = 0;
-        for (DSimpleListItem *item:*d->selectionItems) {
-            int index = d->renderItems->indexOf(item);
+        for (int row:d->selectionRows) {
+            int index = d->renderRows.indexOf(row);
 
             if (index < firstIndex) {
                 firstIndex = index;
@@ -1574,14 +1990,14 @@ void DSimpleListView::shiftSelectNextItemWithOffset(int scrollOffset)
         }
 
         if (firstIndex != -1) {
-            int lastSelectionIndex = d->renderItems->indexOf(d->lastSelectItem);
+            int lastSelectionIndex = d->renderRows.indexOf(d->lastSelectRow);
             int selectionStartIndex, selectionEndIndex;
 
             if (firstIndex == lastSelectionIndex) {
                 selectionStartIndex = firstIndex;
-                selectionEndIndex = std::min(d->renderItems->count() - 1, lastIndex + scrollOffset);
+                selectionEndIndex = std::min(d->renderRows.count() - 1, lastIndex + scrollOffset);
             } else {
-                selectionStartIndex = std::min(d->renderItems->count() - 1, firstIndex + scrollOffset);
+                selectionStartIndex = std::min(d->renderRows.count() - 1, firstIndex + scrollOffset);
                 selectionEndIndex = lastIndex;
             }
 
@@ -1592,7 +2008,7 @@ void DSimpleListView::shiftSelectNextItemWithOffset(int scrollOffset)
             }
 
 
-            repaint();
+            update();
         }
     }
 }
@@ -1601,7 +2017,16 @@ QList<int> DSimpleListView::getRenderWidths()
 {
     D_D(DSimpleListView);
 
-    QList<int> renderWidths;
+    // Reuse the widths of last time if the width and column visibility are unchanged.
+    if (d->renderWidthsWidth == rect().width() && d->renderWidthsColumnVisibles == columnVisibles) {
+        return d->renderWidths;
+    }
+
+    QList<int> &renderWidths = d->renderWidths;
+    renderWidths.clear();
+    d->renderWidthsWidth = rect().width();
+    d->renderWidthsColumnVisibles = columnVisibles;
+
     if (d->columnWidths.length() > 0) {
         if (d->columnWidths.contains(-1)) {
             for (int i = 0; i < d->columnWidths.count(); i++) {
@@ -1667,7 +2092,7 @@ int DSimpleListView::adjustRenderOffset(int offset)
 
 int DSimpleListViewPrivate::getItemsTotalHeight()
 {
-    return renderItems->count() * rowHeight;
+    return renderRows.count() * rowHeight;
 }
 
 int DSimpleListView::getScrollAreaHeight()
@@ -1698,20 +2123,326 @@ int DSimpleListViewPrivate::getTopRenderOffset()
     return 0;
 }
 
-QList<DSimpleListItem*> DSimpleListViewPrivate::getSearchItems(QList<DSimpleListItem*> items)
+QVector<int> DSimpleListViewPrivate::getSearchRows(const QVector<int> &rows) const
 {
-    if (searchContent == "" || searchAlgorithm == NULL) {
-        return items;
+    if (searchContent == "") {
+        return rows;
     } else {
-        QList<DSimpleListItem*> *searchItems = new QList<DSimpleListItem*>();
+        return matchRows(source, rows, searchContent, QSharedPointer<QAtomicInt>());
+    }
+}
+
+void DSimpleListViewPrivate::applySearchRows(const QString &content, const QVector<int> &rows)
+{
+    D_Q(DSimpleListView);
+
+    // Rows of new search replace rendering rows at once.
+    searchContent = content;
+    renderRows = rows;
+
+    if (defaultSortingColumn != -1) {
+        sortRowsByColumn(defaultSortingColumn, defaultSortingOrder);
+    }
+
+    renderOffset = q->adjustRenderOffset(renderOffset);
+
+    q->update();
+}
+
+void DSimpleListViewPrivate::cancelSearch()
+{
+    if (!searchPending) {
+        return;
+    }
+
+    searchPending = false;
+    searchCanceled->storeRelease(1);
+    searchWatcher->waitForFinished();
+}
+
+void DSimpleListViewPrivate::finishSearch()
+{
+    if (!searchPending) {
+        return;
+    }
+
+    // Rows of source may change after this, wait for the running search and apply it.
+    searchPending = false;
+    applySearchRows(pendingSearchContent, searchWatcher->result());
+}
+
+const QVector<QVariant> *DSimpleListViewPrivate::getSortKeys(int column)
+{
+    auto iter = sortKeys.find(column);
+
+    if (iter == sortKeys.end()) {
+        QVector<QVariant> keys;
+        int count = source->rowCount();
 
-        for (DSimpleListItem *item : items) {
-            if (searchAlgorithm(item, searchContent)) {
-                searchItems->append(item);
+        // Empty keys mean source doesn't provide keys of column.
+        if (count > 0 && source->sortKey(0, column).isValid()) {
+            keys.reserve(count);
+
+            for (int row = 0; row < count; row++) {
+                keys.append(source->sortKey(row, column));
             }
         }
 
-        return *searchItems;
+        iter = sortKeys.insert(column, keys);
+    }
+
+    return iter->isEmpty() ? NULL : &iter.value();
+}
+
+QVector<int> DSimpleListViewPrivate::getAllRows() const
+{
+    QVector<int> rows(source->rowCount());
+    std::iota(rows.begin(), rows.end(), 0);
+
+    return rows;
+}
+
+QVector<QString> DSimpleListViewPrivate::getSourceKeys() const
+{
+    QVector<QString> keys;
+    keys.reserve(source->rowCount());
+
+    for (int row = 0; row < source->rowCount(); row++) {
+        keys.append(source->rowKey(row));
+    }
+
+    return keys;
+}
+
+bool DSimpleListViewPrivate::isItemMode() const
+{
+    return source == itemSource;
+}
+
+bool DSimpleListViewPrivate::canSort() const
+{
+    if (columnTitles.isEmpty() || sortingOrderes->count() != columnTitles.count()) {
+        return false;
+    }
+
+    // Items are compared by sorting algorithms, data source compares rows itself.
+    return !isItemMode() || sortingAlgorithms->count() == columnTitles.count();
+}
+
+DSimpleListItem *DSimpleListViewPrivate::itemAt(int row) const
+{
+    if (!isItemMode() || row < 0 || row >= itemSource->items.count()) {
+        return NULL;
+    }
+
+    return itemSource->items[row];
+}
+
+QList<DSimpleListItem*> DSimpleListViewPrivate::itemsAt(const QList<int> &rows) const
+{
+    QList<DSimpleListItem*> items;
+    items.reserve(rows.count());
+
+    for (int row : rows) {
+        if (DSimpleListItem *item = itemAt(row)) {
+            items.append(item);
+        }
+    }
+
+    return items;
+}
+
+QList<int> DSimpleListViewPrivate::rowsOf(const QList<DSimpleListItem*> &items) const
+{
+    QList<int> rows;
+
+    if (items.count() == 1) {
+        int row = itemSource->items.indexOf(items.first());
+        if (row != -1) {
+            rows.append(row);
+        }
+
+        return rows;
+    }
+
+    QHash<const DSimpleListItem*, int> itemRows;
+    itemRows.reserve(itemSource->items.count());
+    for (int row = 0; row < itemSource->items.count(); row++) {
+        itemRows.insert(itemSource->items[row], row);
+    }
+
+    for (DSimpleListItem *item : items) {
+        int row = itemRows.value(item, -1);
+        if (row != -1) {
+            rows.append(row);
+        }
+    }
+
+    return rows;
+}
+
+void DSimpleListViewPrivate::cacheSortKeys()
+{
+    // Only keys of the sorting column are compared after refreshing.
+    if (defaultSortingColumn != -1) {
+        getSortKeys(defaultSortingColumn);
+    }
+}
+
+void DSimpleListViewPrivate::remapRows(const QVector<QString> &oldKeys, const QVector<QString> &newKeys)
+{
+    // Cached keys still belong to old rows, compare them with keys of new rows.
+    QHash<int, QVector<QVariant>> oldSortKeys = sortKeys;
+    sortKeys.clear();
+
+    // Match old and new rows by key, keep the first row if keys are duplicated.
+    // Rows with empty key never match.
+    QHash<QString, int> keyRows;
+    keyRows.reserve(newKeys.count());
+
+    for (int row = 0; row < newKeys.count(); row++) {
+        if (!newKeys[row].isEmpty() && !keyRows.contains(newKeys[row])) {
+            keyRows.insert(newKeys[row], row);
+        }
+    }
+
+    auto newRowOf = [&](int oldRow) -> int {
+        if (oldRow < 0 || oldRow >= oldKeys.count() || oldKeys[oldRow].isEmpty()) {
+            return -1;
+        }
+
+        return keyRows.value(oldKeys[oldRow], -1);
+    };
+
+    // Save selection rows, last selection row and hover rows.
+    QList<int> newSelectionRows;
+    for (int row : selectionRows) {
+        int newRow = newRowOf(row);
+        if (newRow != -1) {
+            newSelectionRows.append(newRow);
+        }
+    }
+
+    selectionRows = newSelectionRows;
+    lastSelectRow = newRowOf(lastSelectRow);
+    lastHoverRow = newRowOf(lastHoverRow);
+    drawHoverRow = newRowOf(drawHoverRow);
+    mouseHoverRow = newRowOf(mouseHoverRow);
+
+    // Keep the previous row order, so the list is still sorted if no row moves.
+    QVector<int> oldRows(newKeys.count(), -1);
+    QVector<int> orderedRows;
+    orderedRows.reserve(newKeys.count());
+
+    for (int row : renderRows) {
+        int newRow = newRowOf(row);
+
+        if (newRow != -1 && oldRows[newRow] == -1) {
+            oldRows[newRow] = row;
+            orderedRows.append(newRow);
+        }
+    }
+
+    bool hasNewRows = false;
+    for (int row = 0; row < newKeys.count(); row++) {
+        if (oldRows[row] == -1) {
+            orderedRows.append(row);
+            hasNewRows = true;
+        }
+    }
+
+    renderRows = getSearchRows(orderedRows);
+
+    // Compare keys of column between old row and new row, rows without keys are treated as changed.
+    auto keyChanged = [&](int row, int column) -> bool {
+        auto iter = oldSortKeys.constFind(column);
+        const QVector<QVariant> *keys = getSortKeys(column);
+
+        if (iter == oldSortKeys.constEnd() || iter->isEmpty() || keys == NULL || oldRows[row] == -1) {
+            return true;
+        }
+
+        return iter->at(oldRows[row]) != keys->at(row);
+    };
+
+    // Matched rows keep their order, only new rows and changed keys of sorting column need sorting.
+    if (defaultSortingColumn != -1) {
+        bool needSort = hasNewRows;
+
+        for (int i = 0; !needSort && i < renderRows.count(); i++) {
+            needSort = keyChanged(renderRows[i], defaultSortingColumn);
+        }
+
+        if (needSort) {
+            sortRowsByColumn(defaultSortingColumn, defaultSortingOrder);
+        }
+    }
+}
+
+void DSimpleListViewPrivate::removeRow(int row)
+{
+    if (row < 0) {
+        return;
+    }
+
+    sortKeys.clear();
+
+    // Rows after removed row move forward.
+    auto adjustRow = [row](int r) {
+        return r == row ? -1 : (r > row ? r - 1 : r);
+    };
+
+    QVector<int> newRenderRows;
+    newRenderRows.reserve(renderRows.count());
+    for (int r : renderRows) {
+        if (r != row) {
+            newRenderRows.append(adjustRow(r));
+        }
+    }
+    renderRows = newRenderRows;
+
+    QList<int> newSelectionRows;
+    for (int r : selectionRows) {
+        if (r != row) {
+            newSelectionRows.append(adjustRow(r));
+        }
+    }
+    selectionRows = newSelectionRows;
+
+    lastSelectRow = adjustRow(lastSelectRow);
+    lastHoverRow = adjustRow(lastHoverRow);
+    drawHoverRow = adjustRow(drawHoverRow);
+    mouseHoverRow = adjustRow(mouseHoverRow);
+
+    if (isItemMode()) {
+        itemSource->items.removeAt(row);
+    }
+}
+
+void DSimpleListViewPrivate::resetRows()
+{
+    sortKeys.clear();
+    selectionRows.clear();
+    lastSelectRow = -1;
+    lastHoverRow = -1;
+    drawHoverRow = -1;
+    mouseHoverRow = -1;
+
+    renderRows = getSearchRows(getAllRows());
+
+    if (defaultSortingColumn != -1) {
+        sortRowsByColumn(defaultSortingColumn, defaultSortingOrder);
+    }
+}
+
+void DSimpleListViewPrivate::resizeSortingOrderes()
+{
+    while (sortingOrderes->count() < columnTitles.count()) {
+        sortingOrderes->append(false);
+    }
+
+    while (sortingOrderes->count() > columnTitles.count()) {
+        sortingOrderes->removeLast();
     }
 }
 
@@ -1727,12 +2458,22 @@ int DSimpleListView::getBottomRenderOffset()
     }
 }
 
-void DSimpleListViewPrivate::sortItemsByColumn(int column, bool descendingSort)
+void DSimpleListViewPrivate::sortRowsByColumn(int column, bool descendingSort)
 {
-    if (sortingAlgorithms->count() != 0 && sortingAlgorithms->count() == columnTitles.count() && sortingOrderes->count() == columnTitles.count()) {
-        qSort(renderItems->begin(), renderItems->end(), [&](const DSimpleListItem *item1, const DSimpleListItem *item2) {
-                return (*sortingAlgorithms)[column](item1, item2, descendingSort);
-            });
+    if (canSort() && column < columnTitles.count()) {
+        if (const QVector<QVariant> *keys = getSortKeys(column)) {
+            // Cached keys are owned by view, compare them in worker threads.
+            stableSortRows(renderRows, [keys, descendingSort](int row1, int row2) {
+                return descendingSort ? compareSortKeys(keys->at(row2), keys->at(row1)) < 0
+                                      : compareSortKeys(keys->at(row1), keys->at(row2)) < 0;
+            }, true);
+        } else {
+            // Only call lessThan in worker threads if source is thread safe.
+            const DSimpleListDataSource *rowSource = source;
+            stableSortRows(renderRows, [rowSource, column, descendingSort](int row1, int row2) {
+                return rowSource->lessThan(row1, row2, column, descendingSort);
+            }, source->canMatchConcurrently());
+        }
     }
 }
 
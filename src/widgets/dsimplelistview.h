@@ -26,6 +26,7 @@
 
 #include "dobject.h"
 #include "dsimplelistitem.h"
+#include "dsimplelistdatasource.h"
 #include <dtkwidget_global.h>
 #include <QPixmap>
 #include <QTimer>
@@ -35,6 +36,8 @@ DWIDGET_BEGIN_NAMESPACE
 
 typedef bool (* SortAlgorithm) (const DSimpleListItem *item1, const DSimpleListItem *item2, bool descendingSort);
 typedef bool (* SearchAlgorithm) (const DSimpleListItem *item, QString searchContent);
+typedef QString (* KeyAlgorithm) (const DSimpleListItem *item);
+typedef QVariant (* SortKeyAlgorithm) (const DSimpleListItem *item);
 
 class DSimpleListViewPrivate;
 class LIBDTKWIDGETSHARED_EXPORT DSimpleListView : public QWidget, public DTK_CORE_NAMESPACE::DObject
@@ -84,13 +87,35 @@ public:
      */
     void setColumnSortingAlgorithms(QList<SortAlgorithm> *algorithms, int sortColumn=-1, bool descendingSort=false);
 
+    /*
+     * Set column sort key algorithms.
+     * Sort keys are cached until items changed, and sorting compares keys instead of calling SortAlgorithm.
+     * Numbers compare by value, other keys compare as string. Use NULL for columns sorted by SortAlgorithm.
+     * Sorting is stable, big lists are sorted on multiple threads, so algorithms must not change items.
+     *
+     * @algorithms a list of SortKeyAlgorithm, it's type is: 'QVariant (*) (const DSimpleListItem *item)'
+     */
+    void setColumnSortKeyAlgorithms(QList<SortKeyAlgorithm> algorithms);
+
     /*
      * Set search algorithm to filter match items.
+     * When search content is extended, only items matching the shorter content are searched again,
+     * so the algorithm should not match more items with longer content, such as QString::contains.
+     * Big lists are searched on a worker thread.
      *
      * @algorithm the search algorithm, it's type is: 'bool (*) (const DSimpleListItem *item, QString searchContent)'
      */
     void setSearchAlgorithm(SearchAlgorithm algorithm);
 
+    /*
+     * Set key algorithm to identify the same item across refreshItems.
+     * With a key algorithm, refreshItems matches old and new items through a hash of keys instead of
+     * calling sameAs for every pair, and keeps the previous row order so only changed rows need sorting.
+     *
+     * @algorithm the key algorithm, it's type is: 'QString (*) (const DSimpleListItem *item)'
+     */
+    void setKeyAlgorithm(KeyAlgorithm algorithm);
+
     /*
      * Set radius to clip listview.
      *
@@ -107,6 +132,25 @@ public:
      */
     void setFrame(bool enableFrame, QColor color=QColor("#000000"), double opacity=0.1);
 
+    /*
+     * Use data source and delegate instead of DSimpleListItem objects, rows of data source
+     * cost an index and a key in DSimpleListView, no QObject is created for each row.
+     * DSimpleListView doesn't take ownership of source and delegate.
+     * Item interfaces (addItems, refreshItems, getSelections...) don't work with data source.
+     *
+     * @source the data source, set with NULL to use DSimpleListItem objects again
+     * @delegate the delegate to draw rows of source, set with NULL when source is NULL
+     * @sortColumn default sort column, -1 mean don't sort any column default
+     * @descendingSort whether sort column descending, default is false
+     */
+    void setDataSource(DSimpleListDataSource *source, DSimpleListDelegate *delegate, int sortColumn=-1, bool descendingSort=false);
+
+    /*
+     * Refresh rows after data source changed.
+     * Rows with same key keep selection status and order, scroll offset is kept.
+     */
+    void refreshRows();
+
     /*
      * Add DSimpleListItem list to ListView.
      * If user has click title to sort, sort items after add items to list.
@@ -136,6 +180,14 @@ public:
      */
     void addSelections(QList<DSimpleListItem*> items, bool recordLastSelection=true);
 
+    /*
+     * Add rows to mark selected effect in ListView.
+     *
+     * @rows List of row index in source to mark selected
+     * @recordLastSelection record last selection row to make selected operation continuously, default is true
+     */
+    void addSelectionRows(QList<int> rows, bool recordLastSelection=true);
+
     /*
      * Clear selection items from DSimpleListView.
      *
@@ -151,6 +203,13 @@ public:
      */
     QList<DSimpleListItem*> getSelections();
 
+    /*
+     * Get selection rows.
+     *
+     * @return List of row index in source to mark selected
+     */
+    QList<int> getSelectionRows();
+
     /*
      * Refresh all items in DSimpleListView.
      * This function is different that addItems is: it will clear items first before add new items.
@@ -161,7 +220,8 @@ public:
     void refreshItems(QList<DSimpleListItem*> items);
 
     /*
-     * Search
+     * Search items with search algorithm.
+     * Big lists are searched on a worker thread, the result replaces the rendered items when finished.
      */
     void search(QString searchContent);
     
@@ -246,6 +306,13 @@ Q_SIGNALS:
     void mousePressChanged(DSimpleListItem* item, int columnIndex, QPoint pos);
     void mouseReleaseChanged(DSimpleListItem* item, int columnIndex, QPoint pos);
 
+    void rightClickRows(QPoint pos, QList<int> rows);
+    void changeHoverRow(QPoint pos, int row, int columnIndex);
+
+    void mouseHoverRowChanged(int oldRow, int newRow, int columnIndex, QPoint pos);
+    void mousePressRowChanged(int row, int columnIndex, QPoint pos);
+    void mouseReleaseRowChanged(int row, int columnIndex, QPoint pos);
+
 protected:
     bool eventFilter(QObject *, QEvent *event);
     void keyPressEvent(QKeyEvent *keyEvent);
@@ -1,9 +1,9 @@
 #include "dspinner.h"
+#include "private/danimationclock_p.h"
 
 #include <QtMath>
 #include <QPainter>
 #include <QPainterPath>
-#include <QTimer>
 #include <QEvent>
 
 #include <DObjectPrivate>
@@ -17,7 +17,8 @@ public:
 
     QList<QColor> createDefaultIndicatorColorList(QColor color);
 
-    QTimer refreshTimer;
+    // 旋转动画由所有动画控件共用的时钟驱动
+    static const int refreshInterval = 30;
 
     double indicatorShadowOffset = 10;
     double currentDegree = 0.0;
@@ -65,19 +66,12 @@ DSpinner::DSpinner(QWidget *parent) :
 {
     Q_D(DSpinner);
 
-    d->refreshTimer.setInterval(30);
     d->colorGroup = palette().currentColorGroup();
-
-    connect(&d->refreshTimer, &QTimer::timeout,
-    this, [ = ]() {
-        d->currentDegree += 14;
-        update();
-    });
 }
 
 DSpinner::~DSpinner()
 {
-
+    DAnimationClock::unregisterWidget(this);
 }
 
 /*!
@@ -86,8 +80,7 @@ DSpinner::~DSpinner()
  */
 bool DSpinner::isPlaying() const
 {
-    Q_D(const DSpinner);
-    return d->refreshTimer.isActive();
+    return DAnimationClock::isRegistered(this);
 }
 
 /*!
@@ -97,7 +90,11 @@ bool DSpinner::isPlaying() const
 void DSpinner::start()
 {
     Q_D(DSpinner);
-    d->refreshTimer.start();
+
+    DAnimationClock::registerWidget(this, d->refreshInterval, [this, d] {
+        d->currentDegree += 14;
+        update();
+    });
 }
 
 /*!
@@ -106,8 +103,7 @@ void DSpinner::start()
  */
 void DSpinner::stop()
 {
-    Q_D(DSpinner);
-    d->refreshTimer.stop();
+    DAnimationClock::unregisterWidget(this);
 }
 
 /*!
@@ -20,13 +20,15 @@
  */
 #include "dstyle.h"
 #include "dstyleoption.h"
+#include "private/dblurengine_p.h"
 
 #include <DGuiApplicationHelper>
 
 #include <QStyleOption>
 #include <QTextLayout>
 #include <QTextLine>
-#include <QPixmapCache>
+#include <QCache>
+#include <QThread>
 #include <QGuiApplication>
 #include <QAbstractItemView>
 #include <QPainterPath>
@@ -37,11 +39,7 @@
 #include <private/qicon_p.h>
 
 #include <math.h>
-
-QT_BEGIN_NAMESPACE
-//extern Q_WIDGETS_EXPORT void qt_blurImage(QImage &blurImage, qreal radius, bool quality, int transposed = 0);
-extern Q_WIDGETS_EXPORT void qt_blurImage(QPainter *p, QImage &blurImage, qreal radius, bool quality, bool alphaOnly, int transposed = 0);
-QT_END_NAMESPACE
+#include <cstring>
 
 DGUI_USE_NAMESPACE
 DWIDGET_BEGIN_NAMESPACE
@@ -131,16 +129,10 @@ static QImage dropShadow(const QPixmap &px, qreal radius, const QColor &color)
     tmpPainter.end();
 
     // blur the alpha channel
-    QImage blurred(tmp.size(), QImage::Format_ARGB32_Premultiplied);
-    blurred.fill(0);
-    QPainter blurPainter(&blurred);
-    qt_blurImage(&blurPainter, tmp, radius, false, true);
-    blurPainter.end();
+    DBlurEngine::blur(tmp, radius, true, DBlurEngine::downsampleFactor(radius));
 
     if (color == QColor(Qt::black))
-        return blurred;
-
-    tmp = blurred;
+        return tmp;
 
     // blacken the image...
     tmpPainter.begin(&tmp);
@@ -151,61 +143,114 @@ static QImage dropShadow(const QPixmap &px, qreal radius, const QColor &color)
     return tmp;
 }
 
-static QList<QRect> sudokuByRect(const QRect &rect, QMargins borders)
+static void sudokuByRect(const QRect &rect, const QMargins &borders, QRect list[9])
 {
-    QList<QRect> list;
+    const QRect &contentsRect = rect - borders;
 
-//    qreal border_width = borders.left() + borders.right();
+    list[0] = QRect(rect.topLeft(), QSize(borders.left(), borders.top()));
+    list[1] = QRect(list[0].topRight(), QSize(contentsRect.width(), borders.top())).translated(1, 0);
+    list[2] = QRect(list[1].topRight(), QSize(borders.right(), borders.top())).translated(1, 0);
+    list[3] = QRect(list[0].bottomLeft(), QSize(borders.left(), contentsRect.height())).translated(0, 1);
+    list[4] = contentsRect;
+    list[5] = QRect(contentsRect.topRight(), QSize(borders.right(), contentsRect.height())).translated(1, 0);
+    list[6] = QRect(list[3].bottomLeft(), QSize(borders.left(), borders.bottom())).translated(0, 1);
+    list[7] = QRect(contentsRect.bottomLeft(), QSize(contentsRect.width(), borders.bottom())).translated(0, 1);
+    list[8] = QRect(contentsRect.bottomRight(), QSize(borders.right(), borders.bottom())).translated(1, 1);
+}
+
+// 圆角矩形阴影的九宫格切片，半径以 1/64 设备像素为单位
+struct ShadowAtlasKey
+{
+    qint32 xRadius;
+    qint32 yRadius;
+    qint32 radius;
+    QRgb color;
 
-//    if ( border_width > rect.width()) {
-//        borders.setLeft(borders.left() / border_width * rect.width());
-//        borders.setRight(rect.width() - borders.left());
-//    }
+    bool operator==(const ShadowAtlasKey &other) const
+    {
+        return xRadius == other.xRadius && yRadius == other.yRadius
+               && radius == other.radius && color == other.color;
+    }
+};
 
-//    qreal border_height = borders.top() + borders.bottom();
+inline uint qHash(const ShadowAtlasKey &key, uint seed = 0)
+{
+    return ::qHash(key.xRadius, seed) ^ ::qHash(key.yRadius, seed + 1)
+           ^ ::qHash(key.radius, seed + 2) ^ ::qHash(key.color, seed + 3);
+}
 
-//    if (border_height > rect.height()) {
-//        borders.setTop(borders.top()/ border_height * rect.height());
-//        borders.setBottom(rect.height() - borders.top());
-//    }
+struct ShadowAtlas
+{
+    QPixmap slices[9];
+};
 
-    const QRect &contentsRect = rect - borders;
+// 任意路径的阴影，路径相同且大小不变时可以直接复用
+struct PathShadowKey
+{
+    uint pathHash;
+    qint32 width;
+    qint32 height;
+    qint32 radius;
+    qint32 scale;
+    QRgb color;
 
-    list << QRect(0, 0, borders.left(), borders.top());
-    list << QRect(list.at(0).topRight(), QSize(contentsRect.width(), borders.top())).translated(1, 0);
-    list << QRect(list.at(1).topRight(), QSize(borders.right(), borders.top())).translated(1, 0);
-    list << QRect(list.at(0).bottomLeft(), QSize(borders.left(), contentsRect.height())).translated(0, 1);
-    list << contentsRect;
-    list << QRect(contentsRect.topRight(), QSize(borders.right(), contentsRect.height())).translated(1, 0);
-    list << QRect(list.at(3).bottomLeft(), QSize(borders.left(), borders.bottom())).translated(0, 1);
-    list << QRect(contentsRect.bottomLeft(), QSize(contentsRect.width(), borders.bottom())).translated(0, 1);
-    list << QRect(contentsRect.bottomRight(), QSize(borders.left(), borders.bottom())).translated(1, 1);
+    bool operator==(const PathShadowKey &other) const
+    {
+        return pathHash == other.pathHash && width == other.width && height == other.height
+               && radius == other.radius && scale == other.scale && color == other.color;
+    }
+};
 
-    return list;
+inline uint qHash(const PathShadowKey &key, uint seed = 0)
+{
+    return key.pathHash ^ ::qHash(key.width, seed) ^ ::qHash(key.height, seed + 1)
+           ^ ::qHash(key.radius, seed + 2) ^ ::qHash(key.scale, seed + 3) ^ ::qHash(key.color, seed + 4);
 }
 
-static QImage borderImage(const QPixmap &px, const QMargins &borders, const QSize &size, QImage::Format format)
+struct PathShadow
 {
-    QImage image(size, format);
-    QPainter pa(&image);
+    // 哈希冲突时用于区分不同的路径
+    QPainterPath path;
+    QPixmap shadow;
+};
+
+// 缓存上限以 KB 为单位
+static QCache<ShadowAtlasKey, ShadowAtlas> shadowAtlasCache(4096);
+static QCache<PathShadowKey, PathShadow> pathShadowCache(8192);
 
-    const QList<QRect> sudoku_src = sudokuByRect(px.rect(), borders);
-    const QList<QRect> sudoku_tar = sudokuByRect(QRect(QPoint(0, 0), size), borders);
+static void clearShadowCaches()
+{
+    shadowAtlasCache.clear();
+    pathShadowCache.clear();
+}
 
-    pa.setCompositionMode(QPainter::CompositionMode_Source);  //设置组合模式
+// QPixmap 需要在应用程序对象销毁前释放
+static void registerShadowCachesCleanup()
+{
+    static bool registered = false;
 
-    for (int i = 0; i < 9; ++i) {
-        pa.drawPixmap(sudoku_tar[i], px, sudoku_src[i]);
+    if (!registered) {
+        qAddPostRoutine(clearShadowCaches);
+        registered = true;
     }
+}
 
-    pa.end();
+static uint pathHash(const QPainterPath &path)
+{
+    uint hash = ::qHash(int(path.fillRule()));
+
+    for (int i = 0; i < path.elementCount(); ++i) {
+        const QPainterPath::Element &element = path.elementAt(i);
+
+        hash = 31 * hash + ::qHash(element.x, uint(element.type));
+        hash = 31 * hash + ::qHash(element.y);
+    }
 
-    return image;
+    return hash;
 }
 
 void drawShadow(QPainter *pa, const QRect &rect, qreal xRadius, qreal yRadius, const QColor &sc, qreal radius, const QPoint &offset)
 {
-    QPixmap shadow;
     qreal scale = pa->paintEngine()->paintDevice()->devicePixelRatioF();
     QRect shadow_rect = rect;
 
@@ -215,9 +260,11 @@ void drawShadow(QPainter *pa, const QRect &rect, qreal xRadius, qreal yRadius, c
     yRadius *= scale;
     radius *= scale;
 
-    const QString &key = QString("dtk-shadow-%1x%2-%3-%4").arg(xRadius).arg(yRadius).arg(sc.name()).arg(radius);
+    const QMargins margins(xRadius + radius, yRadius + radius, xRadius + radius, yRadius + radius);
+    const ShadowAtlasKey key {qRound(xRadius * 64), qRound(yRadius * 64), qRound(radius * 64), sc.rgba()};
+    const ShadowAtlas *atlas = shadowAtlasCache.object(key);
 
-    if (!QPixmapCache::find(key, shadow)) {
+    if (!atlas) {
         QImage shadow_base(QSize(xRadius * 3, yRadius * 3), QImage::Format_ARGB32_Premultiplied);
         shadow_base.fill(0);
         QPainter pa(&shadow_base);
@@ -228,46 +275,86 @@ void drawShadow(QPainter *pa, const QRect &rect, qreal xRadius, qreal yRadius, c
         pa.end();
 
         shadow_base = dropShadow(QPixmap::fromImage(shadow_base), radius, sc);
-        shadow = QPixmap::fromImage(shadow_base);
-        QPixmapCache::insert(key, shadow);
+
+        ShadowAtlas *new_atlas = new ShadowAtlas;
+        QRect sudoku_src[9];
+        int cost = 0;
+
+        sudokuByRect(shadow_base.rect(), margins, sudoku_src);
+
+        for (int i = 0; i < 9; ++i) {
+            if (sudoku_src[i].isEmpty())
+                continue;
+
+            new_atlas->slices[i] = QPixmap::fromImage(shadow_base.copy(sudoku_src[i]));
+            cost += sudoku_src[i].width() * sudoku_src[i].height() * 4;
+        }
+
+        registerShadowCachesCleanup();
+        shadowAtlasCache.insert(key, new_atlas, qMax(1, cost / 1024));
+        atlas = new_atlas;
     }
 
-    const QMargins margins(xRadius + radius, yRadius + radius, xRadius + radius, yRadius + radius);
-    QImage new_shadow = borderImage(shadow, margins, shadow_rect.size() * scale, QImage::Format_ARGB32_Premultiplied);
-//    QPainter pa_shadow(&new_shadow);
-//    pa_shadow.setCompositionMode(QPainter::CompositionMode_Clear);
-//    pa_shadow.setPen(Qt::NoPen);
-//    pa_shadow.setBrush(Qt::transparent);
-//    pa_shadow.setRenderHint(QPainter::Antialiasing);
-//    pa_shadow.drawRoundedRect((new_shadow.rect() - QMargins(radius, radius, radius, radius)).translated(-offset), xRadius, yRadius);
-//    pa_shadow.end();
-    new_shadow.setDevicePixelRatio(scale);
-    pa->drawImage(shadow_rect.topLeft(), new_shadow);
+    // 在设备像素上切分目标区域，再直接绘制每个切片，各切片的边界都对齐到像素上
+    QRect sudoku_tar[9];
+    sudokuByRect(QRect(QPoint(0, 0), shadow_rect.size() * scale), margins, sudoku_tar);
+
+    for (int i = 0; i < 9; ++i) {
+        const QPixmap &slice = atlas->slices[i];
+
+        if (slice.isNull() || sudoku_tar[i].isEmpty())
+            continue;
+
+        const QRectF target(QPointF(sudoku_tar[i].topLeft()) / scale + shadow_rect.topLeft(),
+                            QSizeF(sudoku_tar[i].size()) / scale);
+
+        pa->drawPixmap(target, slice, QRectF(slice.rect()));
+    }
 }
 
 void drawShadow(QPainter *pa, const QRect &rect, const QPainterPath &path, const QColor &sc, int radius, const QPoint &offset)
 {
-    QPixmap shadow;
     qreal scale = pa->paintEngine()->paintDevice()->devicePixelRatioF();
     QRect shadow_rect = rect;
 
     shadow_rect.setTopLeft(rect.topLeft() + offset);
     radius *= scale;
 
-    QImage shadow_base(shadow_rect.size() * scale, QImage::Format_ARGB32_Premultiplied);
-    shadow_base.fill(0);
-    shadow_base.setDevicePixelRatio(scale);
+    const QSize &image_size = shadow_rect.size() * scale;
+    const PathShadowKey key {pathHash(path), image_size.width(), image_size.height(), radius, qRound(scale * 64), sc.rgba()};
+    const PathShadow *cached = pathShadowCache.object(key);
+
+    // 控件几何不变时重绘直接使用上次模糊的结果
+    if (!cached || cached->path != path) {
+        QImage shadow_base(image_size, QImage::Format_ARGB32_Premultiplied);
+        shadow_base.fill(0);
+        shadow_base.setDevicePixelRatio(scale);
+
+        QPainter paTmp(&shadow_base);
+        paTmp.setBrush(sc);
+        paTmp.setPen(Qt::NoPen);
+        paTmp.drawPath(path);
+        paTmp.end();
+        shadow_base = dropShadow(QPixmap::fromImage(shadow_base), radius, sc);
 
-    QPainter paTmp(&shadow_base);
-    paTmp.setBrush(sc);
-    paTmp.setPen(Qt::NoPen);
-    paTmp.drawPath(path);
-    paTmp.end();
-    shadow_base = dropShadow(QPixmap::fromImage(shadow_base), radius, sc);
-    shadow = QPixmap::fromImage(shadow_base);
-    shadow.setDevicePixelRatio(scale);
+        PathShadow *new_cached = new PathShadow;
+        new_cached->path = path;
+        new_cached->shadow = QPixmap::fromImage(shadow_base);
+        new_cached->shadow.setDevicePixelRatio(scale);
 
-    pa->drawPixmap(shadow_rect, shadow);
+        registerShadowCachesCleanup();
+        // 超过缓存上限的阴影不会被缓存，insert 会直接删除它，需要先取出结果
+        const QPixmap shadow = new_cached->shadow;
+
+        if (!pathShadowCache.insert(key, new_cached, qMax(1, shadow_base.bytesPerLine() * shadow_base.height() / 1024))) {
+            pa->drawPixmap(shadow_rect, shadow);
+            return;
+        }
+
+        cached = new_cached;
+    }
+
+    pa->drawPixmap(shadow_rect, cached->shadow);
 }
 
 void drawFork(QPainter *pa, const QRectF &rect, const QColor &color, int width)
@@ -2304,6 +2391,123 @@ QSizeF DStyle::viewItemTextLayout(QTextLayout &textLayout, int lineWidth)
     return QSizeF(widthUsed, height);
 }
 
+// 视图项文本的排版结果，绘制和计算大小时共用，避免每次都重新分词和断行。
+// 对齐方式不影响断行，绘制前再设置；不换行时行宽与断行无关，统一按 QFIXED_MAX 排版
+struct ViewItemTextKey
+{
+    QString text;
+    QFont font;
+    int lineWidth;
+    bool wrapText;
+    int direction;
+
+    bool operator==(const ViewItemTextKey &other) const
+    {
+        return lineWidth == other.lineWidth && wrapText == other.wrapText && direction == other.direction
+               && text == other.text && font == other.font;
+    }
+};
+
+inline uint qHash(const ViewItemTextKey &key, uint seed = 0)
+{
+    return qHash(key.text, seed) ^ qHash(key.font, seed) ^ ::qHash(key.lineWidth, seed + 1)
+           ^ ::qHash((uint(key.wrapText) << 4) ^ uint(key.direction), seed + 2);
+}
+
+// 省略后的文本，按绘制区域的大小和省略方式在第一次绘制时计算
+struct ViewItemElidedText
+{
+    int width = 0;
+    int height = 0;
+    int elideMode = 0;
+    QString text;
+    int index = -1;
+    qreal drawWidth = 0;
+    qreal drawHeight = 0;
+};
+
+struct ViewItemText
+{
+    // 只保留最近使用的几种绘制区域
+    enum { MaxElidedCount = 2 };
+
+    QTextLayout layout;
+    QSizeF size;
+    QVector<ViewItemElidedText> elided;
+};
+
+class ViewItemTextCache
+{
+public:
+    // 缓存上限以 KB 为单位
+    enum { MaxCost = 4 * 1024 };
+
+    ViewItemTextCache()
+        : cache(MaxCost)
+    {
+        // QTextLayout 需要在应用程序对象销毁前释放
+        qAddPostRoutine(clearGlobalCache);
+    }
+
+    // 返回的对象属于缓存，只能在下一次查找前使用；不能缓存时由 uncached 持有
+    ViewItemText *find(const ViewItemTextKey &key, const QTextOption &textOption, QScopedPointer<ViewItemText> &uncached)
+    {
+        const int cost = itemCost(key.text.size());
+        const bool cacheable = qApp && QThread::currentThread() == qApp->thread() && cost < MaxCost;
+
+        if (cacheable) {
+            if (ViewItemText *item = cache.object(key)) {
+                ++hits;
+                return item;
+            }
+
+            ++misses;
+        }
+
+        ViewItemText *item = new ViewItemText;
+
+        item->layout.setText(key.text);
+        item->layout.setFont(key.font);
+        item->layout.setTextOption(textOption);
+        item->size = DStyle::viewItemTextLayout(item->layout, key.lineWidth);
+
+        if (cacheable) {
+            cache.insert(key, item, qMax(cost, itemCost(key.text.size(), item->layout.lineCount())));
+        } else {
+            uncached.reset(item);
+        }
+
+        return item;
+    }
+
+    static void clearGlobalCache();
+
+    quint64 hits = 0;
+    quint64 misses = 0;
+
+private:
+    // 绘制后 QTextLayout 保留每个字符的属性、log cluster 和字形数组（字形、advance、offset 等），
+    // 每个字符约 40 字节，另外还有省略后的文本和每行的排版信息
+    static int itemCost(int length, int lineCount = 1)
+    {
+        const qint64 bytes = qint64(sizeof(ViewItemText)) + qint64(sizeof(QTextEngine))
+                             + qint64(length) * (40 + ViewItemText::MaxElidedCount * 2)
+                             + qint64(lineCount) * qint64(sizeof(QScriptLine));
+
+        return int((bytes + 1023) / 1024);
+    }
+
+    QCache<ViewItemTextKey, ViewItemText> cache;
+};
+
+Q_GLOBAL_STATIC(ViewItemTextCache, viewItemTextCache)
+
+void ViewItemTextCache::clearGlobalCache()
+{
+    if (viewItemTextCache.exists())
+        viewItemTextCache->cache.clear();
+}
+
 /*!
  * \~chinese \brief DStyle::viewItemSize 视图项大小
  * \~chinese \param\sa style QStyle()
@@ -2322,11 +2526,10 @@ QSize DStyle::viewItemSize(const QStyle *style, const QStyleOptionViewItem *opti
         break;
     case Qt::DisplayRole:
         if (option->features & QStyleOptionViewItem::HasDisplay) {
-            QTextOption textOption;
-            textOption.setWrapMode(QTextOption::WordWrap);
-            QTextLayout textLayout(option->text, option->font);
-            textLayout.setTextOption(textOption);
             const bool wrapText = option->features & QStyleOptionViewItem::WrapText;
+            QTextOption textOption;
+            textOption.setWrapMode(wrapText ? QTextOption::WordWrap : QTextOption::ManualWrap);
+            textOption.setTextDirection(option->direction);
             int spacing = DStyleHelper(style).pixelMetric(DStyle::PM_ContentsSpacing, option, widget);
             QRect bounds = option->rect;
             switch (option->decorationPosition) {
@@ -2355,8 +2558,10 @@ QSize DStyle::viewItemSize(const QStyle *style, const QStyleOptionViewItem *opti
             if (wrapText && option->features & QStyleOptionViewItem::HasCheckIndicator)
                 bounds.setWidth(bounds.width() - style->pixelMetric(QStyle::PM_IndicatorWidth) - spacing);
 
-            const int lineWidth = bounds.width();
-            const QSizeF size = viewItemTextLayout(textLayout, lineWidth);
+            const ViewItemTextKey key {option->text, option->font, wrapText ? bounds.width() : QFIXED_MAX, wrapText,
+                                       option->direction};
+            QScopedPointer<ViewItemText> uncached;
+            const QSizeF size = viewItemTextCache->find(key, textOption, uncached)->size;
             return QSize(qCeil(size.width()), qCeil(size.height()));
         }
         break;
@@ -2582,49 +2787,81 @@ QRect DStyle::viewItemDrawText(const QStyle *style, QPainter *p, const QStyleOpt
     Q_UNUSED(style)
     QRect textRect = rect;
     const bool wrapText = option->features & QStyleOptionViewItem::WrapText;
+    const Qt::Alignment alignment = QStyle::visualAlignment(option->direction, option->displayAlignment);
     QTextOption textOption;
     textOption.setWrapMode(wrapText ? QTextOption::WordWrap : QTextOption::ManualWrap);
     textOption.setTextDirection(option->direction);
-    textOption.setAlignment(QStyle::visualAlignment(option->direction, option->displayAlignment));
-    QTextLayout textLayout(option->text, option->font);
+    // 不换行时按 QFIXED_MAX 排版，行内对齐在下面按绘制区域的宽度计算
+    textOption.setAlignment(wrapText ? alignment : Qt::AlignLeft | Qt::AlignAbsolute);
+    const ViewItemTextKey key {option->text, option->font, wrapText ? textRect.width() : QFIXED_MAX, wrapText,
+                               option->direction};
+    QScopedPointer<ViewItemText> uncached;
+    ViewItemText *item = viewItemTextCache->find(key, textOption, uncached);
+    QTextLayout &textLayout = item->layout;
+    const int lineCount = textLayout.lineCount();
+
+    // 计算大小时创建的排版没有对齐方式，对齐只在绘制时生效，不需要重新排版
     textLayout.setTextOption(textOption);
 
-    viewItemTextLayout(textLayout, textRect.width());
+    ViewItemElidedText *elided = nullptr;
+    for (ViewItemElidedText &e : item->elided) {
+        if (e.width == textRect.width() && e.height == textRect.height() && e.elideMode == option->textElideMode) {
+            elided = &e;
+            break;
+        }
+    }
 
-    QString elidedText;
-    qreal height = 0;
-    qreal width = 0;
-    int elidedIndex = -1;
-    const int lineCount = textLayout.lineCount();
-    for (int j = 0; j < lineCount; ++j) {
-        const QTextLine line = textLayout.lineAt(j);
-        if (j + 1 <= lineCount - 1) {
-            const QTextLine nextLine = textLayout.lineAt(j + 1);
-            if ((nextLine.y() + nextLine.height()) > textRect.height()) {
+    if (!elided) {
+        if (item->elided.size() >= ViewItemText::MaxElidedCount)
+            item->elided.removeFirst();
+
+        item->elided.append(ViewItemElidedText());
+        elided = &item->elided.last();
+        elided->width = textRect.width();
+        elided->height = textRect.height();
+        elided->elideMode = option->textElideMode;
+
+        qreal height = 0;
+        qreal width = 0;
+
+        for (int j = 0; j < lineCount; ++j) {
+            const QTextLine line = textLayout.lineAt(j);
+            if (j + 1 <= lineCount - 1) {
+                const QTextLine nextLine = textLayout.lineAt(j + 1);
+                if ((nextLine.y() + nextLine.height()) > textRect.height()) {
+                    int start = line.textStart();
+                    int length = line.textLength() + nextLine.textLength();
+                    const QStackTextEngine engine(textLayout.text().mid(start, length), option->font);
+                    elided->text = engine.elidedText(option->textElideMode, textRect.width());
+                    height += line.height();
+                    width = textRect.width();
+                    elided->index = j;
+                    break;
+                }
+            }
+            if (line.naturalTextWidth() > textRect.width()) {
                 int start = line.textStart();
-                int length = line.textLength() + nextLine.textLength();
+                int length = line.textLength();
                 const QStackTextEngine engine(textLayout.text().mid(start, length), option->font);
-                elidedText = engine.elidedText(option->textElideMode, textRect.width());
+                elided->text = engine.elidedText(option->textElideMode, textRect.width());
                 height += line.height();
                 width = textRect.width();
-                elidedIndex = j;
+                elided->index = j;
                 break;
             }
-        }
-        if (line.naturalTextWidth() > textRect.width()) {
-            int start = line.textStart();
-            int length = line.textLength();
-            const QStackTextEngine engine(textLayout.text().mid(start, length), option->font);
-            elidedText = engine.elidedText(option->textElideMode, textRect.width());
-            height += line.height();
             width = textRect.width();
-            elidedIndex = j;
-            break;
+            height += line.height();
         }
-        width = qMax<qreal>(width, line.width());
-        height += line.height();
+
+        elided->drawWidth = width;
+        elided->drawHeight = height;
     }
 
+    const QString &elidedText = elided->text;
+    const int elidedIndex = elided->index;
+    const qreal width = elided->drawWidth;
+    const qreal height = elided->drawHeight;
+
     const QRect layoutRect = QStyle::alignedRect(option->direction, option->displayAlignment,
                                                  QSize(int(width), int(height)), textRect);
     const QPointF position = layoutRect.topLeft();
@@ -2639,7 +2876,17 @@ QRect DStyle::viewItemDrawText(const QStyle *style, QPainter *p, const QStyleOpt
             p->restore();
             break;
         }
-        line.draw(p, position);
+        if (wrapText) {
+            line.draw(p, position);
+        } else {
+            const qreal space = textRect.width() - line.naturalTextWidth();
+            qreal offset = 0;
+            if (alignment & Qt::AlignRight)
+                offset = space;
+            else if (alignment & Qt::AlignHCenter)
+                offset = space / 2;
+            line.draw(p, QPointF(position.x() + offset, position.y()));
+        }
     }
 
     return layoutRect;
@@ -2653,6 +2900,24 @@ QRect DStyle::viewItemDrawText(QPainter *p, const QStyleOptionViewItem *option,
 {
     return viewItemDrawText(this, p, option, rect);
 }
+
+/*!
+ * \~chinese \brief DStyle::viewItemTextCacheHits
+ * \~chinese \return viewItemSize 和 viewItemDrawText 命中文本排版缓存的次数
+ */
+quint64 DStyle::viewItemTextCacheHits()
+{
+    return viewItemTextCache.exists() ? viewItemTextCache->hits : 0;
+}
+
+/*!
+ * \~chinese \brief DStyle::viewItemTextCacheMisses
+ * \~chinese \return viewItemSize 和 viewItemDrawText 未命中文本排版缓存、重新排版的次数
+ */
+quint64 DStyle::viewItemTextCacheMisses()
+{
+    return viewItemTextCache.exists() ? viewItemTextCache->misses : 0;
+}
 #endif
 
 
@@ -2666,6 +2931,121 @@ void DStyledIconEngine::drawIcon(const QIcon &icon, QPainter *pa, const QRectF &
     icon.paint(pa, rect.toRect());
 }
 
+// 图标按绘制参数缓存，所有字段均为 32 位整数，可以按字节比较
+struct IconPixmapKey
+{
+    qint32 width;
+    qint32 height;
+    qint32 scale;
+    qint32 margin;
+    qint32 mode;
+    qint32 state;
+    QRgb penColor;
+    qint32 penWidth;
+    qint32 penStyle;
+    QRgb brushColor;
+    qint32 brushStyle;
+    qint32 renderHints;
+
+    bool operator==(const IconPixmapKey &other) const
+    {
+        return memcmp(this, &other, sizeof(IconPixmapKey)) == 0;
+    }
+};
+
+inline uint qHash(const IconPixmapKey &key, uint seed = 0)
+{
+    return qHashBits(&key, sizeof(IconPixmapKey), seed);
+}
+
+struct IconPixmapCache
+{
+    // 缓存上限以 KB 为单位
+    QCache<IconPixmapKey, QPixmap> pixmaps {256};
+    qint64 paletteCacheKey = 0;
+};
+
+// 缓存不放在 DStyledIconEngine 中以保持其二进制兼容，引擎析构时删除对应的缓存
+class IconPixmapCacheHash : public QHash<const DStyledIconEngine *, IconPixmapCache *>
+{
+public:
+    ~IconPixmapCacheHash()
+    {
+        qDeleteAll(*this);
+    }
+};
+
+Q_GLOBAL_STATIC(IconPixmapCacheHash, iconPixmapCaches)
+
+static bool isSolidBrush(const QBrush &brush)
+{
+    return brush.style() == Qt::NoBrush || brush.style() == Qt::SolidPattern;
+}
+
+static void applyFrontRole(QPainter *painter, const QWidget *widget, QPalette::ColorRole role)
+{
+    if (role == QPalette::NoRole)
+        return;
+
+    const QPalette &palette = widget ? widget->palette() : qApp->palette();
+
+    painter->setPen(palette.brush(role).color());
+    painter->setBrush(palette.brush(role));
+}
+
+static QPixmap renderIconPixmap(const DStyledIconEngine::DrawFun &drawFun, const QSize &size, qreal scale, int margin,
+                                const QPen &pen, const QBrush &brush, QPainter::RenderHints hints)
+{
+    const QSize &full_size = size + QSize(2 * margin, 2 * margin);
+    QImage image(full_size * scale, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    image.setDevicePixelRatio(scale);
+
+    QPainter pa(&image);
+    pa.setRenderHints(hints);
+    pa.setPen(pen);
+    pa.setBrush(brush);
+    pa.translate(margin, margin);
+    drawFun(&pa, QRect(QPoint(0, 0), size));
+    pa.end();
+
+    return QPixmap::fromImage(image);
+}
+
+static QPixmap cachedIconPixmap(const DStyledIconEngine *engine, const DStyledIconEngine::DrawFun &drawFun, const QWidget *widget,
+                                const QSize &size, qreal scale, int margin, QIcon::Mode mode, QIcon::State state,
+                                const QPen &pen, const QBrush &brush, QPainter::RenderHints hints)
+{
+    IconPixmapCache *&cache = (*iconPixmapCaches)[engine];
+
+    if (!cache)
+        cache = new IconPixmapCache;
+
+    // 调色板或主题变化后清空缓存
+    const qint64 palette_key = (widget ? widget->palette() : qApp->palette()).cacheKey();
+
+    if (cache->paletteCacheKey != palette_key) {
+        cache->pixmaps.clear();
+        cache->paletteCacheKey = palette_key;
+    }
+
+    const IconPixmapKey key {
+        size.width(), size.height(), qRound(scale * 64), margin, mode, state,
+        pen.color().rgba(), qRound(pen.widthF() * 64),
+        qint32(pen.style()) | qint32(pen.capStyle()) | qint32(pen.joinStyle()),
+        brush.style() == Qt::NoBrush ? 0 : brush.color().rgba(), qint32(brush.style()), qint32(hints)
+    };
+
+    if (const QPixmap *pixmap = cache->pixmaps.object(key))
+        return *pixmap;
+
+    const QPixmap &pixmap = renderIconPixmap(drawFun, size, scale, margin, pen, brush, hints);
+    const QSize &pixel_size = pixmap.size();
+    cache->pixmaps.insert(key, new QPixmap(pixmap), qMax(1, pixel_size.width() * pixel_size.height() * 4 / 1024));
+
+    return pixmap;
+}
+
 /*!
  * \~chinese \brief DStyledIconEngine::DStyledIconEngine
  * \~chinese \param drawFun
@@ -2680,6 +3060,12 @@ DStyledIconEngine::DStyledIconEngine(DrawFun drawFun, const QString &iconName)
     m_widget = nullptr;
 }
 
+DStyledIconEngine::~DStyledIconEngine()
+{
+    if (!iconPixmapCaches.isDestroyed())
+        delete iconPixmapCaches->take(this);
+}
+
 /*!
  * \~chinese \brief DStyledIconEngine::bindDrawFun活页夹
  * \~chinese \param drawFun
@@ -2687,6 +3073,9 @@ DStyledIconEngine::DStyledIconEngine(DrawFun drawFun, const QString &iconName)
 void DStyledIconEngine::bindDrawFun(DrawFun drawFun)
 {
     m_drawFun = drawFun;
+
+    if (IconPixmapCache *cache = iconPixmapCaches->value(this))
+        cache->pixmaps.clear();
 }
 
 /*!
@@ -2704,13 +3093,24 @@ void DStyledIconEngine::setIconName(const QString &name)
  */
 QPixmap DStyledIconEngine::pixmap(const QSize &size, QIcon::Mode mode, QIcon::State state)
 {
-    QImage image(size, QImage::Format_ARGB32_Premultiplied);
-    image.fill(Qt::transparent);
-    QPainter pa(&image);
-    paint(&pa, QRect(QPoint(0, 0), size), mode, state);
-    pa.end();
+    if (!m_drawFun || size.isEmpty())
+        return QPixmap();
 
-    return QPixmap::fromImage(image);
+    QPen pen;
+    QBrush brush;
+
+    if (m_painterRole != QPalette::NoRole) {
+        const QPalette &palette = m_widget ? m_widget->palette() : qApp->palette();
+
+        pen = QPen(palette.brush(m_painterRole).color());
+        brush = palette.brush(m_painterRole);
+    }
+
+    // 纹理和渐变画刷不能只用颜色区分，和 paint 一样直接绘制
+    if (!isSolidBrush(brush))
+        return renderIconPixmap(m_drawFun, size, 1.0, 0, pen, brush, QPainter::RenderHints());
+
+    return cachedIconPixmap(this, m_drawFun, m_widget, size, 1.0, 0, mode, state, pen, brush, QPainter::RenderHints());
 }
 
 /*!
@@ -2736,20 +3136,29 @@ void DStyledIconEngine::paint(QPainter *painter, const QPalette &palette, const
  */
 void DStyledIconEngine::paint(QPainter *painter, const QRect &rect, QIcon::Mode mode, QIcon::State state)
 {
-    Q_UNUSED(mode)
-    Q_UNUSED(state)
+    if (!m_drawFun)
+        return;
 
-    if (m_painterRole != QPalette::NoRole) {
-        if (m_widget) {
-            painter->setPen(m_widget->palette().brush(m_painterRole).color());
-            painter->setBrush(m_widget->palette().brush(m_painterRole));
-        } else {
-            painter->setPen(qApp->palette().brush(m_painterRole).color());
-            painter->setBrush(qApp->palette().brush(m_painterRole));
-        }
+    applyFrontRole(painter, m_widget, m_painterRole);
+
+    const QPen &pen = painter->pen();
+    const QBrush &brush = painter->brush();
+
+    // 只有平移时缓存的图像和直接绘制的结果一致，其它情况直接绘制
+    if (rect.isEmpty() || painter->transform().type() > QTransform::TxTranslate
+            || painter->compositionMode() != QPainter::CompositionMode_SourceOver
+            || !isSolidBrush(pen.brush()) || !isSolidBrush(brush)) {
+        m_drawFun(painter, rect);
+        return;
     }
 
-    m_drawFun(painter, rect);
+    // 留出画笔宽度的边距，避免线条超出 rect 的部分被裁剪
+    const int margin = qCeil(pen.widthF()) + 1;
+    const qreal scale = painter->device()->devicePixelRatioF();
+    const QPixmap &pixmap = cachedIconPixmap(this, m_drawFun, m_widget, rect.size(), scale, margin, mode, state,
+                                             pen, brush, painter->renderHints());
+
+    painter->drawPixmap(rect.topLeft() - QPoint(margin, margin), pixmap);
 }
 
 /*!
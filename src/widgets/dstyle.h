@@ -303,6 +303,9 @@ public:
 
     static QRect viewItemDrawText(const QStyle *style, QPainter *p, const QStyleOptionViewItem *option, const QRect &rect);
     virtual QRect viewItemDrawText(QPainter *p, const QStyleOptionViewItem *option, const QRect &rect) const;
+
+    static quint64 viewItemTextCacheHits();
+    static quint64 viewItemTextCacheMisses();
 #endif
 };
 
@@ -431,6 +434,7 @@ public:
 
     typedef std::function<void(QPainter *, const QRectF &rect)> DrawFun;
     DStyledIconEngine(DrawFun drawFun, const QString &iconName = QString());
+    ~DStyledIconEngine() override;
 
     void bindDrawFun(DrawFun drawFun);
     void setIconName(const QString &name);
@@ -35,6 +35,11 @@
 #include <QLineEdit>
 #include <QTableView>
 #include <QListWidget>
+#include <QScrollBar>
+#include <QPointer>
+#include <QCache>
+#include <QSet>
+#include <QPixmap>
 #include <private/qlayoutengine_p.h>
 
 Q_DECLARE_METATYPE(QMargins)
@@ -62,6 +67,79 @@ public:
     qint8 fontSize = -1;
 };
 
+// 项的绘制结果按索引和绘制参数缓存，构造时清零以便按字节比较
+struct ItemPixmapKey
+{
+    const QAbstractItemModel *model;
+    const QStyle *style;
+    quintptr internalId;
+    qint64 paletteCacheKey;
+    qint32 row;
+    qint32 column;
+    qint32 width;
+    qint32 height;
+    qint32 scale;
+    quint32 state;
+    quint32 flags;
+    quint32 fontHash;
+
+    ItemPixmapKey()
+    {
+        memset(this, 0, sizeof(ItemPixmapKey));
+    }
+
+    bool operator==(const ItemPixmapKey &other) const
+    {
+        return memcmp(this, &other, sizeof(ItemPixmapKey)) == 0;
+    }
+};
+
+inline uint qHash(const ItemPixmapKey &key, uint seed = 0)
+{
+    return qHashBits(&key, sizeof(ItemPixmapKey), seed);
+}
+
+// 预先从模型中取出的项数据，避免每次绘制都从 QVariant 中转换
+struct ItemDescriptor
+{
+    bool hasMargins = false;
+    bool hasWidget = false;
+    QMargins margins;
+    DViewItemActionList leftActions;
+    DViewItemActionList rightActions;
+    DViewItemActionList topActions;
+    DViewItemActionList bottomActions;
+    DViewItemActionList textActions;
+};
+
+// 缓存的绘制结果按所在行索引，数据变化时只需要查找变化的行
+struct ItemRowKey
+{
+    quintptr parentId;
+    qint32 parentRow;
+    qint32 parentColumn;
+    qint32 row;
+
+    bool operator==(const ItemRowKey &other) const
+    {
+        return parentId == other.parentId && parentRow == other.parentRow
+                && parentColumn == other.parentColumn && row == other.row;
+    }
+};
+
+inline uint qHash(const ItemRowKey &key, uint seed = 0)
+{
+    return ::qHash(key.parentId, seed) ^ ::qHash((static_cast<quint64>(static_cast<quint32>(key.parentRow)) << 32)
+                                                 | static_cast<quint32>(key.row), seed + 1)
+            ^ static_cast<uint>(key.parentColumn);
+}
+
+struct ItemPixmap
+{
+    QPixmap pixmap;
+    QList<QPair<QAction*, QRect>> clickableActions;
+};
+
 class DStyledItemDelegatePrivate : public DCORE_NAMESPACE::DObjectPrivate
 {
 public:
@@ -294,9 +372,9 @@ public:
         }
     }
 
-    static QSize drawActions(QPainter *pa, const QStyleOptionViewItem &option, const QVariant &value, Qt::Edge edge, QList<QPair<QAction*, QRect>> *clickableActionRect)
+    static QSize drawActions(QPainter *pa, const QStyleOptionViewItem &option, const DViewItemActionList &actionList, Qt::Edge edge,
+                             int spacing, QList<QPair<QAction*, QRect>> *clickableActionRect)
     {
-        const DViewItemActionList &actionList = qvariant_cast<DViewItemActionList>(value);
         DViewItemActionList visiable_actionList;
         for (auto action : actionList) {
             if (action->isVisible()) {
@@ -314,7 +392,6 @@ public:
         QSize bounding;
         const QList<QRect> &list = doActionsLayout(option.rect, visiable_actionList, orientation, option.direction, option.decorationSize, &bounding);
         QPoint origin(0, 0);
-        int spacing = DStyleHelper(qApp->style()).pixelMetric(DStyle::PM_ContentsSpacing);
 
         switch (edge) {
         case Qt::BottomEdge:
@@ -345,8 +422,354 @@ public:
     QMargins margins;
     QSize itemSize;
     int itemSpacing = 0;
+    bool uniformItemSizes = false;
+
+    // 统一尺寸模式下只测量一次，字体、图标大小、布局方向等影响测量结果的参数变化后重新测量
+    struct UniformSizeCache {
+        QSize size;
+        QFont font;
+        QSize decorationSize;
+        Qt::LayoutDirection direction = Qt::LeftToRight;
+        const QWidget *widget = nullptr;
+        int flow = -1;
+    };
+    mutable UniformSizeCache uniformSizeCache;
+
+    bool isUniform(const QStyleOptionViewItem &option) const
+    {
+        if (uniformItemSizes)
+            return true;
+
+        const QListView *lv = qobject_cast<const QListView*>(option.widget);
+        return lv && lv->uniformItemSizes();
+    }
+
+    static int listFlow(const QStyleOptionViewItem &option)
+    {
+        const QListView *lv = qobject_cast<const QListView*>(option.widget);
+        return lv ? static_cast<int>(lv->flow()) : -1;
+    }
+
+    QSize cachedUniformSize(const QStyleOptionViewItem &option) const
+    {
+        const UniformSizeCache &cache = uniformSizeCache;
+
+        if (!cache.size.isValid()
+                || cache.widget != option.widget
+                || cache.direction != option.direction
+                || cache.decorationSize != option.decorationSize
+                || cache.flow != listFlow(option)
+                || cache.font != option.font) {
+            return QSize();
+        }
+
+        return cache.size;
+    }
+
+    QSize setUniformSize(const QStyleOptionViewItem &option, const QSize &size) const
+    {
+        uniformSizeCache.size = size;
+        uniformSizeCache.font = option.font;
+        uniformSizeCache.decorationSize = option.decorationSize;
+        uniformSizeCache.direction = option.direction;
+        uniformSizeCache.widget = option.widget;
+        uniformSizeCache.flow = listFlow(option);
+
+        return size;
+    }
+
+    void clearUniformSize()
+    {
+        uniformSizeCache = UniformSizeCache();
+    }
+    // 可见项的可点击区域，区域坐标相对于项的左上角，滚动后无需更新
     QMap<QModelIndex, QList<QPair<QAction*, QRect>>> clickableActionMap;
     QAction *pressedAction = nullptr;
+    QPointer<const QAbstractItemModel> clickableActionModel;
+
+    // 模型的行列或者布局变化后，索引不再对应原来的项
+    void watchModel(const QAbstractItemModel *model)
+    {
+        if (clickableActionModel == model)
+            return;
+
+        D_Q(DStyledItemDelegate);
+
+        if (clickableActionModel)
+            QObject::disconnect(clickableActionModel, nullptr, q, nullptr);
+
+        clickableActionMap.clear();
+        clearItemCaches();
+        clickableActionModel = model;
+
+        if (!model)
+            return;
+
+        auto clear = [this] {
+            clickableActionMap.clear();
+            pressedAction = nullptr;
+            clearItemCaches();
+        };
+
+        QObject::connect(model, &QAbstractItemModel::dataChanged, q, [this] (const QModelIndex &topLeft, const QModelIndex &bottomRight) {
+            removeCachedItems(topLeft, bottomRight);
+        });
+        QObject::connect(model, &QAbstractItemModel::modelReset, q, clear);
+        QObject::connect(model, &QAbstractItemModel::layoutChanged, q, clear);
+        QObject::connect(model, &QAbstractItemModel::rowsInserted, q, clear);
+        QObject::connect(model, &QAbstractItemModel::rowsRemoved, q, clear);
+        QObject::connect(model, &QAbstractItemModel::rowsMoved, q, clear);
+        QObject::connect(model, &QAbstractItemModel::columnsInserted, q, clear);
+        QObject::connect(model, &QAbstractItemModel::columnsRemoved, q, clear);
+        QObject::connect(model, &QAbstractItemModel::columnsMoved, q, clear);
+    }
+
+    // 滚动后移除已经不可见的项，只保留视口内的项
+    void removeInvisibleClickableActions()
+    {
+        D_Q(DStyledItemDelegate);
+
+        QAbstractItemView *view = qobject_cast<QAbstractItemView*>(q->parent());
+
+        if (!view)
+            return;
+
+        const QRect &viewport_rect = view->viewport()->rect();
+
+        for (auto it = clickableActionMap.begin(); it != clickableActionMap.end();) {
+            if (view->visualRect(it.key()).intersects(viewport_rect)) {
+                ++it;
+            } else {
+                it = clickableActionMap.erase(it);
+            }
+        }
+    }
+
+    // 以下缓存只在开启 paintCacheEnabled 后使用，模型结构变化时全部清空，数据变化时清除对应的项
+    bool paintCacheEnabled = false;
+    bool paintingToCache = false;
+    // 缓存上限以 KB 为单位
+    QCache<ItemPixmapKey, ItemPixmap> itemPixmapCache {8192};
+    mutable QCache<QModelIndex, ItemDescriptor> itemDescriptorCache {2048};
+    // 项中 action 的内容变化时不会触发 dataChanged，需要单独监听
+    mutable QSet<const QAction*> watchedActions;
+
+    // 缓存淘汰的项不会从中移除，记录过多时按缓存中现有的项重建
+    QHash<ItemRowKey, QVector<ItemPixmapKey>> itemPixmapRows;
+    int itemPixmapRowEntries = 0;
+
+    static ItemRowKey itemRowKey(const QModelIndex &parent, int row)
+    {
+        return ItemRowKey {parent.internalId(), parent.row(), parent.column(), row};
+    }
+
+    void clearItemPixmaps()
+    {
+        itemPixmapCache.clear();
+        itemPixmapRows.clear();
+        itemPixmapRowEntries = 0;
+    }
+
+    void clearItemCaches()
+    {
+        clearItemPixmaps();
+        itemDescriptorCache.clear();
+    }
+
+    void insertItemPixmap(const ItemPixmapKey &key, const QModelIndex &index, ItemPixmap *pixmap, int cost)
+    {
+        if (!itemPixmapCache.insert(key, pixmap, cost))
+            return;
+
+        itemPixmapRows[itemRowKey(index.parent(), index.row())].append(key);
+
+        if (++itemPixmapRowEntries > 2 * itemPixmapCache.count() + 64) {
+            itemPixmapRowEntries = 0;
+
+            for (auto it = itemPixmapRows.begin(); it != itemPixmapRows.end();) {
+                QVector<ItemPixmapKey> &keys = it.value();
+                QVector<ItemPixmapKey> alive_keys;
+
+                for (const ItemPixmapKey &cached_key : keys) {
+                    if (itemPixmapCache.contains(cached_key) && !alive_keys.contains(cached_key))
+                        alive_keys.append(cached_key);
+                }
+
+                if (alive_keys.isEmpty()) {
+                    it = itemPixmapRows.erase(it);
+                } else {
+                    keys = alive_keys;
+                    itemPixmapRowEntries += keys.size();
+                    ++it;
+                }
+            }
+        }
+    }
+
+    void removeCachedItems(const QModelIndex &topLeft, const QModelIndex &bottomRight)
+    {
+        if (itemPixmapCache.isEmpty() && itemDescriptorCache.isEmpty())
+            return;
+
+        const QAbstractItemModel *model = topLeft.model();
+        const QModelIndex &parent = topLeft.parent();
+        const int row_count = bottomRight.row() - topLeft.row() + 1;
+        const int column_count = bottomRight.column() - topLeft.column() + 1;
+
+        // 变化的项较少时逐个移除，否则遍历缓存
+        if (qint64(row_count) * column_count <= itemDescriptorCache.count()) {
+            for (int row = topLeft.row(); row <= bottomRight.row(); ++row) {
+                for (int column = topLeft.column(); column <= bottomRight.column(); ++column)
+                    itemDescriptorCache.remove(model->index(row, column, parent));
+            }
+        } else {
+            for (const QModelIndex &index : itemDescriptorCache.keys()) {
+                if (index.row() >= topLeft.row() && index.row() <= bottomRight.row()
+                        && index.column() >= topLeft.column() && index.column() <= bottomRight.column()
+                        && index.parent() == parent) {
+                    itemDescriptorCache.remove(index);
+                }
+            }
+        }
+
+        auto remove_row = [&] (QHash<ItemRowKey, QVector<ItemPixmapKey>>::iterator it) {
+            QVector<ItemPixmapKey> &keys = it.value();
+
+            for (int i = keys.size() - 1; i >= 0; --i) {
+                if (keys[i].column < topLeft.column() || keys[i].column > bottomRight.column())
+                    continue;
+
+                itemPixmapCache.remove(keys[i]);
+                keys.remove(i);
+                --itemPixmapRowEntries;
+            }
+
+            return keys.isEmpty() ? itemPixmapRows.erase(it) : it + 1;
+        };
+
+        if (row_count <= itemPixmapRows.size()) {
+            for (int row = topLeft.row(); row <= bottomRight.row(); ++row) {
+                auto it = itemPixmapRows.find(itemRowKey(parent, row));
+
+                if (it != itemPixmapRows.end())
+                    remove_row(it);
+            }
+        } else {
+            const ItemRowKey &parent_key = itemRowKey(parent, 0);
+
+            for (auto it = itemPixmapRows.begin(); it != itemPixmapRows.end();) {
+                const ItemRowKey &key = it.key();
+
+                if (key.parentId == parent_key.parentId && key.parentRow == parent_key.parentRow
+                        && key.parentColumn == parent_key.parentColumn
+                        && key.row >= topLeft.row() && key.row <= bottomRight.row()) {
+                    it = remove_row(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+    }
+
+    void watchActions(const DViewItemActionList &list) const
+    {
+        D_QC(DStyledItemDelegate);
+
+        DStyledItemDelegatePrivate *self = const_cast<DStyledItemDelegatePrivate*>(this);
+        DStyledItemDelegate *delegate = const_cast<DStyledItemDelegate*>(q);
+
+        for (const DViewItemAction *action : list) {
+            if (watchedActions.contains(action))
+                continue;
+
+            watchedActions.insert(action);
+            QObject::connect(action, &QAction::changed, delegate, [self] {
+                self->clearItemCaches();
+            });
+            QObject::connect(action, &QObject::destroyed, delegate, [self, action] {
+                self->watchedActions.remove(action);
+                self->clearItemCaches();
+            });
+        }
+    }
+
+    static ItemDescriptor decodeItem(const QModelIndex &index)
+    {
+        ItemDescriptor item;
+        const QVariant &margins = index.data(Dtk::MarginsRole);
+
+        if (margins.isValid()) {
+            item.hasMargins = true;
+            item.margins = qvariant_cast<QMargins>(margins);
+        }
+
+        item.leftActions = qvariant_cast<DViewItemActionList>(index.data(Dtk::LeftActionListRole));
+        item.rightActions = qvariant_cast<DViewItemActionList>(index.data(Dtk::RightActionListRole));
+        item.topActions = qvariant_cast<DViewItemActionList>(index.data(Dtk::TopActionListRole));
+        item.bottomActions = qvariant_cast<DViewItemActionList>(index.data(Dtk::BottomActionListRole));
+        item.textActions = qvariant_cast<DViewItemActionList>(index.data(Dtk::TextActionListRole));
+
+        for (const DViewItemActionList *list : {&item.leftActions, &item.rightActions, &item.topActions, &item.bottomActions}) {
+            for (const DViewItemAction *action : *list) {
+                if (action->widget()) {
+                    item.hasWidget = true;
+                    break;
+                }
+            }
+        }
+
+        return item;
+    }
+
+    ItemDescriptor itemDescriptor(const QModelIndex &index) const
+    {
+        if (!paintCacheEnabled)
+            return decodeItem(index);
+
+        if (const ItemDescriptor *item = itemDescriptorCache.object(index))
+            return *item;
+
+        const_cast<DStyledItemDelegatePrivate*>(this)->watchModel(index.model());
+
+        ItemDescriptor *item = new ItemDescriptor(decodeItem(index));
+
+        watchActions(item->leftActions);
+        watchActions(item->rightActions);
+        watchActions(item->topActions);
+        watchActions(item->bottomActions);
+        watchActions(item->textActions);
+        itemDescriptorCache.insert(index, item);
+
+        return *item;
+    }
+
+    static ItemPixmapKey itemPixmapKey(const QStyleOptionViewItem &option, const QModelIndex &index, const QStyle *style, bool editing, qreal scale)
+    {
+        ItemPixmapKey key;
+        const QStyle::State state_mask = QStyle::State_Enabled | QStyle::State_Active | QStyle::State_Selected
+                | QStyle::State_HasFocus | QStyle::State_MouseOver | QStyle::State_Sunken | QStyle::State_Open
+                | QStyle::State_Editing | QStyle::State_Children | QStyle::State_Sibling;
+
+        key.model = index.model();
+        key.style = style;
+        key.internalId = index.internalId();
+        key.paletteCacheKey = option.palette.cacheKey();
+        key.row = index.row();
+        key.column = index.column();
+        key.width = option.rect.width();
+        key.height = option.rect.height();
+        key.scale = qRound(scale * 1000);
+        key.state = static_cast<quint32>(option.state & state_mask);
+        key.flags = static_cast<quint32>(option.viewItemPosition)
+                | (static_cast<quint32>(option.direction) << 4)
+                | (static_cast<quint32>(option.showDecorationSelected) << 6)
+                | (static_cast<quint32>(editing) << 7)
+                | (static_cast<quint32>(option.features) << 8);
+        key.fontHash = qHash(option.font) ^ static_cast<quint32>(option.decorationSize.width())
+                ^ (static_cast<quint32>(option.decorationSize.height()) << 16);
+
+        return key;
+    }
 };
 
 /*!
@@ -694,6 +1117,15 @@ DStyledItemDelegate::DStyledItemDelegate(QAbstractItemView *parent)
     //支持QAction的点击
     parent->viewport()->installEventFilter(this);
 
+    auto removeInvisibleActions = [this] {
+        D_D(DStyledItemDelegate);
+
+        d->removeInvisibleClickableActions();
+    };
+
+    connect(parent->horizontalScrollBar(), &QScrollBar::valueChanged, this, removeInvisibleActions);
+    connect(parent->verticalScrollBar(), &QScrollBar::valueChanged, this, removeInvisibleActions);
+
     // 初始化 background type. 注意 setBackgroundType() 中有额外的处理操作，所以不能直接简单的修改默认值
     setBackgroundType(DStyledItemDelegate::RoundedBackground);
 }
@@ -702,11 +1134,6 @@ void DStyledItemDelegate::paint(QPainter *painter, const QStyleOptionViewItem &o
 {
     D_DC(DStyledItemDelegate);
 
-    QStyleOptionViewItem opt(option);
-    initStyleOption(&opt, index);
-
-    QRect backup_opt_rect = opt.rect;
-
     const QWidget *widget = option.widget;
     QStyle *style = widget ? widget->style() : QApplication::style();
     bool editing = false;
@@ -715,6 +1142,60 @@ void DStyledItemDelegate::paint(QPainter *painter, const QStyleOptionViewItem &o
         editing = !qobject_cast<const QListWidget*>(view) && view->isPersistentEditorOpen(index);
     }
 
+    DStyledItemDelegatePrivate *mutable_d = const_cast<DStyledItemDelegatePrivate*>(d);
+    mutable_d->watchModel(index.model());
+
+    const ItemDescriptor &item = d->itemDescriptor(index);
+
+    // 包含控件的项需要每次更新控件的位置，不能使用缓存
+    if (d->paintCacheEnabled && !d->paintingToCache && !item.hasWidget && !option.rect.isEmpty()
+            && painter->worldTransform().type() <= QTransform::TxTranslate) {
+        const qreal scale = painter->device()->devicePixelRatioF();
+        const ItemPixmapKey &key = d->itemPixmapKey(option, index, style, editing, scale);
+
+        if (const ItemPixmap *cached = d->itemPixmapCache.object(key)) {
+            painter->drawPixmap(option.rect.topLeft(), cached->pixmap);
+
+            if (cached->clickableActions.isEmpty()) {
+                mutable_d->clickableActionMap.remove(index);
+            } else {
+                mutable_d->clickableActionMap[index] = cached->clickableActions;
+            }
+
+            return;
+        }
+
+        ItemPixmap *item_pixmap = new ItemPixmap;
+        item_pixmap->pixmap = QPixmap(option.rect.size() * scale);
+        item_pixmap->pixmap.setDevicePixelRatio(scale);
+        item_pixmap->pixmap.fill(Qt::transparent);
+
+        QPainter pa(&item_pixmap->pixmap);
+        pa.setRenderHints(painter->renderHints());
+        pa.setFont(painter->font());
+        pa.setPen(painter->pen());
+        pa.translate(-option.rect.topLeft());
+
+        // 不调用虚函数，子类重写的 paint 调用基类时不会再次进入子类的绘制
+        mutable_d->paintingToCache = true;
+        DStyledItemDelegate::paint(&pa, option, index);
+        mutable_d->paintingToCache = false;
+        pa.end();
+
+        item_pixmap->clickableActions = d->clickableActionMap.value(index);
+        painter->drawPixmap(option.rect.topLeft(), item_pixmap->pixmap);
+
+        const int cost = qMax(1, item_pixmap->pixmap.width() * item_pixmap->pixmap.height() * 4 / 1024);
+        mutable_d->insertItemPixmap(key, index, item_pixmap, cost);
+
+        return;
+    }
+
+    QStyleOptionViewItem opt(option);
+    initStyleOption(&opt, index);
+
+    QRect backup_opt_rect = opt.rect;
+
     if (!editing)
         style->drawPrimitive(QStyle::PE_PanelItemViewItem, &opt, painter, widget);
 
@@ -740,12 +1221,7 @@ void DStyledItemDelegate::paint(QPainter *painter, const QStyleOptionViewItem &o
     }
 
     // 设置内容区域
-    QMargins margins = d->margins;
-    const QVariant &margins_varinat = index.data(Dtk::MarginsRole);
-
-    if (margins_varinat.isValid()) {
-        margins = qvariant_cast<QMargins>(margins_varinat);
-    }
+    const QMargins &margins = item.hasMargins ? item.margins : d->margins;
 
     opt.rect = opt.rect.marginsRemoved(margins);
     QRect itemContentRect = opt.rect;
@@ -753,25 +1229,28 @@ void DStyledItemDelegate::paint(QPainter *painter, const QStyleOptionViewItem &o
     QList<QPair<QAction*, QRect>> clickActionList;
     int spacing = DStyleHelper(qApp->style()).pixelMetric(DStyle::PM_ContentsSpacing);
 
-    action_area_size = d->drawActions(painter, opt, index.data(Dtk::LeftActionListRole), Qt::LeftEdge, &clickActionList);
+    action_area_size = d->drawActions(painter, opt, item.leftActions, Qt::LeftEdge, spacing, &clickActionList);
     itemContentRect.setLeft(itemContentRect.left() + action_area_size.width() + (action_area_size.isNull() ? 0 : spacing));
 
-    action_area_size = d->drawActions(painter, opt, index.data(Dtk::RightActionListRole), Qt::RightEdge, &clickActionList);
+    action_area_size = d->drawActions(painter, opt, item.rightActions, Qt::RightEdge, spacing, &clickActionList);
     itemContentRect.setRight(itemContentRect.right() - action_area_size.width() - (action_area_size.isNull() ? 0 : spacing));
 
-    action_area_size = d->drawActions(painter, opt, index.data(Dtk::TopActionListRole), Qt::TopEdge, &clickActionList);
+    action_area_size = d->drawActions(painter, opt, item.topActions, Qt::TopEdge, spacing, &clickActionList);
     itemContentRect.setTop(itemContentRect.top() + action_area_size.height() + (action_area_size.isNull() ? 0 : spacing));
 
-    action_area_size = d->drawActions(painter, opt, index.data(Dtk::BottomActionListRole), Qt::BottomEdge, &clickActionList);
+    action_area_size = d->drawActions(painter, opt, item.bottomActions, Qt::BottomEdge, spacing, &clickActionList);
     itemContentRect.setBottom(itemContentRect.bottom() - action_area_size.height() - (action_area_size.isNull() ? 0 : spacing));
 
     if (!clickActionList.isEmpty()) {
-        const_cast<DStyledItemDelegatePrivate*>(d)->clickableActionMap[index] = clickActionList;
+        for (auto &action_rect : clickActionList)
+            action_rect.second.translate(-backup_opt_rect.topLeft());
+
+        mutable_d->clickableActionMap[index] = clickActionList;
     } else {
-        const_cast<DStyledItemDelegatePrivate*>(d)->clickableActionMap.remove(index);
+        mutable_d->clickableActionMap.remove(index);
     }
 
-    const DViewItemActionList &text_action_list = qvariant_cast<DViewItemActionList>(index.data(Dtk::TextActionListRole));
+    const DViewItemActionList &text_action_list = item.textActions;
 
     opt.rect = itemContentRect;
     QRect iconRect, textRect, checkRect;
@@ -885,10 +1364,22 @@ QSize DStyledItemDelegate::sizeHint(const QStyleOptionViewItem &option, const QM
         return d->itemSize;
     }
 
+    // 所有项尺寸相同时跳过逐项的布局和文本测量
+    const bool uniform = d->isUniform(option);
+
+    if (uniform) {
+        const QSize &size = d->cachedUniformSize(option);
+
+        if (size.isValid())
+            return size;
+    }
+
     QVariant value = index.data(Qt::SizeHintRole);
 
-    if (value.isValid())
-        return qvariant_cast<QSize>(value);
+    if (value.isValid()) {
+        const QSize &size = qvariant_cast<QSize>(value);
+        return uniform ? d->setUniformSize(option, size) : size;
+    }
 
     const QWidget *widget = option.widget;
     QStyle *style = widget ? widget->style() : QApplication::style();
@@ -897,9 +1388,9 @@ QSize DStyledItemDelegate::sizeHint(const QStyleOptionViewItem &option, const QM
     QRect pixmapRect, textRect, checkRect;
     DStyle::viewItemLayout(style, &opt, &pixmapRect, &textRect, &checkRect, true);
 
-    const DViewItemActionList &text_action_list = qvariant_cast<DViewItemActionList>(index.data(Dtk::TextActionListRole));
+    const ItemDescriptor &item = d->itemDescriptor(index);
 
-    for (const DViewItemAction *action : text_action_list) {
+    for (const DViewItemAction *action : item.textActions) {
         const QSize &action_size = d->displayActionSize(action, style, opt);
         textRect.setWidth(qMax(textRect.width(), action_size.width()));
         textRect.setHeight(textRect.height() + action_size.height());
@@ -907,10 +1398,10 @@ QSize DStyledItemDelegate::sizeHint(const QStyleOptionViewItem &option, const QM
 
     QSize size = (pixmapRect | textRect | checkRect).size();
 
-    const DViewItemActionList &left_actions = qvariant_cast<QList<DViewItemAction*>>(index.data(Dtk::LeftActionListRole));
-    const DViewItemActionList &right_actions = qvariant_cast<QList<DViewItemAction*>>(index.data(Dtk::RightActionListRole));
-    const DViewItemActionList &top_actions = qvariant_cast<QList<DViewItemAction*>>(index.data(Dtk::TopActionListRole));
-    const DViewItemActionList &bottom_actions = qvariant_cast<QList<DViewItemAction*>>(index.data(Dtk::BottomActionListRole));
+    const DViewItemActionList &left_actions = item.leftActions;
+    const DViewItemActionList &right_actions = item.rightActions;
+    const DViewItemActionList &top_actions = item.topActions;
+    const DViewItemActionList &bottom_actions = item.bottomActions;
 
     QSize action_area_size;
     // 获取左边区域大小
@@ -937,12 +1428,7 @@ QSize DStyledItemDelegate::sizeHint(const QStyleOptionViewItem &option, const QM
     size.setHeight(size.height() + action_area_size.height());
     size.setWidth(qMax(size.width(), action_area_size.width()));
 
-    QMargins margins = d->margins;
-    const QVariant &margins_varinat = index.data(Dtk::MarginsRole);
-
-    if (margins_varinat.isValid()) {
-        margins = qvariant_cast<QMargins>(margins_varinat);
-    }
+    const QMargins &margins = item.hasMargins ? item.margins : d->margins;
 
     // 在item高度上添加额外空间来模拟spacing
     const QListView * lv = qobject_cast<const QListView*>(option.widget);
@@ -954,7 +1440,9 @@ QSize DStyledItemDelegate::sizeHint(const QStyleOptionViewItem &option, const QM
         }
     }
 
-    return QRect(QPoint(0, 0), size).marginsAdded(margins).size();
+    size = QRect(QPoint(0, 0), size).marginsAdded(margins).size();
+
+    return uniform ? d->setUniformSize(option, size) : size;
 }
 
 void DStyledItemDelegate::updateEditorGeometry(QWidget *editor, const QStyleOptionViewItem &option, const QModelIndex &index) const
@@ -1028,6 +1516,29 @@ int DStyledItemDelegate::spacing() const
     return d->itemSpacing;
 }
 
+/*!
+ * \~chinese \brief DStyledItemDelegate::uniformItemSizes 是否所有项都使用相同的尺寸
+ * \~chinese \return 为 true 时 sizeHint 只测量一次，之后直接返回缓存的结果
+ * \~chinese \sa setUniformItemSizes QListView::uniformItemSizes
+ */
+bool DStyledItemDelegate::uniformItemSizes() const
+{
+    D_DC(DStyledItemDelegate);
+
+    return d->uniformItemSizes;
+}
+
+/*!
+ * \~chinese \brief DStyledItemDelegate::paintCacheEnabled 是否缓存项的绘制结果
+ * \~chinese \sa setPaintCacheEnabled
+ */
+bool DStyledItemDelegate::paintCacheEnabled() const
+{
+    D_DC(DStyledItemDelegate);
+
+    return d->paintCacheEnabled;
+}
+
 void DStyledItemDelegate::setBackgroundType(DStyledItemDelegate::BackgroundType type)
 {
     D_D(DStyledItemDelegate);
@@ -1048,6 +1559,9 @@ void DStyledItemDelegate::setBackgroundType(DStyledItemDelegate::BackgroundType
         int frame_margin = style->pixelMetric(static_cast<QStyle::PixelMetric>(DStyle::PM_FrameRadius));
         d->margins += frame_margin;
     }
+
+    d->clearUniformSize();
+    d->clearItemPixmaps();
 }
 
 void DStyledItemDelegate::setMargins(const QMargins margins)
@@ -1055,6 +1569,8 @@ void DStyledItemDelegate::setMargins(const QMargins margins)
     D_D(DStyledItemDelegate);
 
     d->margins = margins;
+    d->clearUniformSize();
+    d->clearItemPixmaps();
 }
 
 void DStyledItemDelegate::setItemSize(QSize itemSize)
@@ -1062,6 +1578,7 @@ void DStyledItemDelegate::setItemSize(QSize itemSize)
     D_D(DStyledItemDelegate);
 
     d->itemSize = itemSize;
+    d->clearUniformSize();
 }
 
 void DStyledItemDelegate::setItemSpacing(int spacing)
@@ -1069,6 +1586,44 @@ void DStyledItemDelegate::setItemSpacing(int spacing)
     D_D(DStyledItemDelegate);
 
     d->itemSpacing = spacing;
+    d->clearUniformSize();
+    d->clearItemPixmaps();
+}
+
+/*!
+ * \~chinese \brief DStyledItemDelegate::setUniformItemSizes 设置所有项是否使用相同的尺寸
+ *
+ * \~chinese 开启后 sizeHint 只对第一次请求的项做完整的布局和文本测量，其它项直接使用这个结果，
+ * \~chinese 适用于行数很多且每行内容结构相同的模型。视图为 QListView 且开启了 QListView::uniformItemSizes
+ * \~chinese 时会自动使用此模式。使用 setItemSize 固定尺寸时不需要开启。
+ * \~chinese \param uniform 是否开启
+ */
+void DStyledItemDelegate::setUniformItemSizes(bool uniform)
+{
+    D_D(DStyledItemDelegate);
+
+    d->uniformItemSizes = uniform;
+    d->clearUniformSize();
+}
+
+/*!
+ * \~chinese \brief DStyledItemDelegate::setPaintCacheEnabled 设置是否缓存项的绘制结果
+ *
+ * \~chinese 开启后每个项按状态、尺寸和设备像素比绘制到图片中，项不变时再次绘制只需要绘制这张图片，
+ * \~chinese 同时缓存从模型中取出的边距和 action 列表。模型发出 dataChanged 时清除对应项的缓存，
+ * \~chinese 行列和布局变化时清除所有缓存。适用于内容较少变化的列表，包含控件的项不使用缓存。
+ * \~chinese 子类重写 paint 或者 initStyleOption 并使用了项以外的数据时不应该开启。
+ * \~chinese \param enabled 是否开启
+ */
+void DStyledItemDelegate::setPaintCacheEnabled(bool enabled)
+{
+    D_D(DStyledItemDelegate);
+
+    if (d->paintCacheEnabled == enabled)
+        return;
+
+    d->paintCacheEnabled = enabled;
+    d->clearItemCaches();
 }
 
 void DStyledItemDelegate::initStyleOption(QStyleOptionViewItem *option, const QModelIndex &index) const
@@ -1139,10 +1694,18 @@ bool DStyledItemDelegate::eventFilter(QObject *object, QEvent *event)
 
         QAbstractItemView *view = qobject_cast<QAbstractItemView*>(parent());
         const QModelIndex &index = view->indexAt(ev->pos());
+        auto actions = d->clickableActionMap.constFind(index);
+
+        if (actions == d->clickableActionMap.constEnd())
+            break;
+
+        const QPoint &item_pos = ev->pos() - view->visualRect(index).topLeft();
+        // 触发 action 时可能会修改模型，从而清空 clickableActionMap
+        const QList<QPair<QAction*, QRect>> action_list = actions.value();
 
-        for (auto action_map : d->clickableActionMap.value(index)) {
+        for (auto action_map : action_list) {
             if (action_map.first->isEnabled()
-                    && action_map.second.contains(ev->pos(), true)) {
+                    && action_map.second.contains(item_pos, true)) {
                 if (event->type() == QEvent::MouseButtonRelease
                         && d->pressedAction == action_map.first) {
                     action_map.first->trigger();
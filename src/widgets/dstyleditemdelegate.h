@@ -76,6 +76,8 @@ class DStyledItemDelegate : public QStyledItemDelegate, public DCORE_NAMESPACE::
     Q_PROPERTY(BackgroundType backgroundType READ backgroundType WRITE setBackgroundType)
     Q_PROPERTY(QMargins margins READ margins WRITE setMargins)
     Q_PROPERTY(QSize itemSize READ itemSize WRITE setItemSize)
+    Q_PROPERTY(bool uniformItemSizes READ uniformItemSizes WRITE setUniformItemSizes)
+    Q_PROPERTY(bool paintCacheEnabled READ paintCacheEnabled WRITE setPaintCacheEnabled)
 
 public:
     enum BackgroundType {
@@ -99,12 +101,16 @@ public:
     QMargins margins() const;
     QSize itemSize() const;
     int spacing() const;
+    bool uniformItemSizes() const;
+    bool paintCacheEnabled() const;
 
 public Q_SLOTS:
     void setBackgroundType(BackgroundType backgroundType);
     void setMargins(const QMargins margins);
     void setItemSize(QSize itemSize);
     void setItemSpacing(int spacing);
+    void setUniformItemSizes(bool uniform);
+    void setPaintCacheEnabled(bool enabled);
 
 protected:
     void initStyleOption(QStyleOptionViewItem *option, const QModelIndex &index) const override;
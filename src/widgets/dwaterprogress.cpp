@@ -16,15 +16,17 @@
  */
 
 #include "dwaterprogress.h"
+#include "private/danimationclock_p.h"
 
 #include <QtMath>
-#include <QTimer>
 #include <QPainter>
 #include <QPainterPath>
 #include <QGraphicsDropShadowEffect>
 #include <QEvent>
 #include <QIcon>
 #include <QLinearGradient>
+#include <QElapsedTimer>
+#include <QCache>
 
 #include <DObjectPrivate>
 #include <DSvgRenderer>
@@ -44,6 +46,28 @@ struct Pop {
     double yOffset;
 };
 
+// 水波图片由主题图标渲染，同样大小的控件共用，缓存上限以 KB 为单位
+typedef QCache<QString, QImage> WaterStripCache;
+Q_GLOBAL_STATIC_WITH_ARGS(WaterStripCache, waterStripCache, (16 * 1024))
+
+static QImage waterStrip(const QString &name, const QSize &size)
+{
+    const QString &key = QStringLiteral("%1_%2x%3_%4").arg(name).arg(size.width()).arg(size.height()).arg(QIcon::themeName());
+
+    if (const QImage *image = waterStripCache->object(key))
+        return *image;
+
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    QPainter waterPainter(&image);
+    QIcon::fromTheme(name).paint(&waterPainter, image.rect());
+    waterPainter.end();
+
+    waterStripCache->insert(key, new QImage(image), qMax(1, image.bytesPerLine() * image.height() / 1024));
+
+    return image;
+}
+
 class DWaterProgressPrivate: public DTK_CORE_NAMESPACE::DObjectPrivate
 {
 public:
@@ -54,18 +78,33 @@ public:
         pops.append(Pop(11, 0.8, 1.6));
     }
 
+    // 正常刷新间隔；数值一段时间没有变化后降低帧率；两帧之间最多移动的时间
+    enum {
+        ActiveInterval = 33,
+        StaticInterval = 100,
+        MaxFrameInterval = 500,
+        StaticTimeout = 3000
+    };
+
     void resizePixmap(QSize sz);
     void initUI();
     void setValue(int v);
     void paint(QPainter *p);
+    void tick();
+    int frameInterval() const;
+    void updateFrameRate();
 
     QImage waterFrontImage;
     QImage waterBackImage;
+    // 以下图片在尺寸变化前重复使用，绘制每一帧时不再分配内存
+    QImage backgroundImage;
+    QImage maskImage;
+    QImage frameImage;
     QString progressText;
-    QTimer *timer               = Q_NULLPTR;
     QList<Pop> pops;
+    QElapsedTimer frameClock;
+    QElapsedTimer valueClock;
 
-    int     interval            = 33;
     int     value;
 
     double  frontXOffset        = 0;
@@ -111,7 +150,7 @@ DWaterProgress::DWaterProgress(QWidget *parent) :
 
 DWaterProgress::~DWaterProgress()
 {
-
+    DAnimationClock::unregisterWidget(this);
 }
 
 /*!
@@ -130,8 +169,16 @@ int DWaterProgress::value() const
  */
 void DWaterProgress::start()
 {
-    D_DC(DWaterProgress);
-    d->timer->start();
+    D_D(DWaterProgress);
+
+    d->frameClock.restart();
+    // 控件不可见时时钟暂停更新，恢复时不补偿暂停的时间
+    DAnimationClock::registerWidget(this, d->frameInterval(), [d] {
+        d->tick();
+    }, [d] (bool paused) {
+        if (!paused)
+            d->frameClock.restart();
+    });
 }
 
 /*!
@@ -140,8 +187,7 @@ void DWaterProgress::start()
  */
 void DWaterProgress::stop()
 {
-    D_DC(DWaterProgress);
-    d->timer->stop();
+    DAnimationClock::unregisterWidget(this);
 }
 
 /*!
@@ -184,6 +230,7 @@ void DWaterProgress::changeEvent(QEvent *e)
         D_D(DWaterProgress);
         d->waterBackImage = QImage();
         d->waterFrontImage = QImage();
+        waterStripCache->clear();
     }
 
     return QWidget::changeEvent(e);
@@ -197,21 +244,47 @@ void DWaterProgressPrivate::resizePixmap(QSize sz)
     auto waterSize = QSizeF(waterWidth, waterHeight).toSize();
 
     if (waterFrontImage.size() != waterSize) {
-        QIcon renderer = QIcon::fromTheme("water_front");
-        QImage image(waterWidth, waterHeight, QImage::Format_ARGB32);
-        image.fill(Qt::transparent);  // partly transparent red-ish background
-        QPainter waterPainter(&image);
-        renderer.paint(&waterPainter, image.rect());
-        waterFrontImage = image;
+        waterFrontImage = waterStrip("water_front", waterSize);
     }
     if (waterBackImage.size() != waterSize) {
-        QIcon renderer = QIcon::fromTheme("water_back");
-        QImage image(waterWidth, waterHeight, QImage::Format_ARGB32);
-        image.fill(Qt::transparent);  // partly transparent red-ish background
-        QPainter waterPainter(&image);
-        renderer.paint(&waterPainter, image.rect());
-        waterBackImage = image;
+        waterBackImage = waterStrip("water_back", waterSize);
     }
+
+    if (frameImage.size() == sz)
+        return;
+
+    frameImage = QImage(sz, QImage::Format_ARGB32_Premultiplied);
+
+    // 圆形容器内的渐变背景
+    backgroundImage = QImage(sz, QImage::Format_ARGB32_Premultiplied);
+    backgroundImage.fill(Qt::transparent);
+    QPainter backgroundPainter(&backgroundImage);
+    backgroundPainter.setRenderHint(QPainter::Antialiasing);
+
+    QPointF pointStart(sz.width() / 2, 0);
+    QPointF pointEnd(sz.width() / 2, sz.height());
+    QLinearGradient linear(pointStart, pointEnd);
+    QColor startColor("#1F08FF");
+    startColor.setAlphaF(1);
+    QColor endColor("#50FFF7");
+    endColor.setAlphaF(0.28);
+    linear.setColorAt(0, startColor);
+    linear.setColorAt(1, endColor);
+    linear.setSpread(QGradient::PadSpread);
+    backgroundPainter.setPen(Qt::NoPen);
+    backgroundPainter.setBrush(linear);
+    backgroundPainter.drawEllipse(backgroundImage.rect().center(), sz.width() / 2 + 1, sz.height() / 2  + 1);
+    backgroundPainter.end();
+
+    // 圆形遮罩，用于裁剪超出容器的水波和文字
+    maskImage = QImage(sz, QImage::Format_ARGB32_Premultiplied);
+    maskImage.fill(Qt::transparent);
+    QPainter maskPainter(&maskImage);
+    maskPainter.setRenderHint(QPainter::Antialiasing);
+    maskPainter.setPen(Qt::NoPen);
+    maskPainter.setBrush(Qt::white);
+    maskPainter.drawEllipse(QRectF(0, 0, sz.width(), sz.height()));
+    maskPainter.end();
 }
 
 void DWaterProgressPrivate::initUI()
@@ -221,61 +294,81 @@ void DWaterProgressPrivate::initUI()
 
     value = 0;
 
-    timer = new QTimer(q);
-    timer->setInterval(interval);
     resizePixmap(q->size());
     frontXOffset = q->width();
     backXOffset = 0;
+    frameClock.start();
+    valueClock.start();
+}
 
-    q->connect(timer, &QTimer::timeout, q, [ = ] {
-        // interval can not be zero, and limit to 1
-        interval = (interval < 1) ? 1 : interval;
+void DWaterProgressPrivate::tick()
+{
+    D_Q(DWaterProgress);
 
-        // move 60% per second
-        double frontXDeta = 40.0 / (1000.0 / interval);
-        // move 90% per second
-        double backXDeta = 60.0 / (1000.0 / interval);
+    // 按实际经过的时间移动，帧率变化时动画速度不变
+    int interval = qBound(1, static_cast<int>(frameClock.restart()), static_cast<int>(MaxFrameInterval));
 
-        int canvasWidth = static_cast<int>(q->width() * q->devicePixelRatioF());
-        frontXOffset -= frontXDeta *canvasWidth / 100;
-        backXOffset += backXDeta *canvasWidth / 100;
+    // move 60% per second
+    double frontXDeta = 40.0 / (1000.0 / interval);
+    // move 90% per second
+    double backXDeta = 60.0 / (1000.0 / interval);
 
-        if (frontXOffset > canvasWidth)
-        {
-            frontXOffset = canvasWidth;
-        }
-        if (frontXOffset < - (waterFrontImage.width() - canvasWidth))
-        {
-            frontXOffset = canvasWidth;
-        }
+    int canvasWidth = static_cast<int>(q->width() * q->devicePixelRatioF());
+    frontXOffset -= frontXDeta *canvasWidth / 100;
+    backXOffset += backXDeta *canvasWidth / 100;
 
-        if (backXOffset > waterBackImage.width())
-        {
-            backXOffset = 0;
-        }
+    if (frontXOffset > canvasWidth)
+    {
+        frontXOffset = canvasWidth;
+    }
+    if (frontXOffset < - (waterFrontImage.width() - canvasWidth))
+    {
+        frontXOffset = canvasWidth;
+    }
 
-        // update pop
-        // move 25% per second default
-        double speed = 25 / (1000.0 / interval) /** 100 / q->height()*/;
-        for (auto &pop : pops)
-        {
-            // yOffset 0 ~ 100;
-            pop.yOffset += speed * pop.ySpeed;
-            if (pop.yOffset < 0) {
-            }
-            if (pop.yOffset > value) {
-                pop.yOffset = 0;
-            }
-            pop.xOffset = qSin((pop.yOffset / 100) * 2 * 3.14) * 18 * pop.xSpeed + 50;
+    if (backXOffset > waterBackImage.width())
+    {
+        backXOffset = 0;
+    }
+
+    // update pop
+    // move 25% per second default
+    double speed = 25 / (1000.0 / interval) /** 100 / q->height()*/;
+    for (auto &pop : pops)
+    {
+        // yOffset 0 ~ 100;
+        pop.yOffset += speed * pop.ySpeed;
+        if (pop.yOffset < 0) {
         }
-        q->update();
-    });
+        if (pop.yOffset > value) {
+            pop.yOffset = 0;
+        }
+        pop.xOffset = qSin((pop.yOffset / 100) * 2 * 3.14) * 18 * pop.xSpeed + 50;
+    }
+
+    updateFrameRate();
+    q->update();
 }
 
 void DWaterProgressPrivate::setValue(int v)
 {
     value = v;
     progressText = QString("%1").arg(v);
+    valueClock.restart();
+    updateFrameRate();
+}
+
+int DWaterProgressPrivate::frameInterval() const
+{
+    return valueClock.elapsed() > StaticTimeout ? StaticInterval : ActiveInterval;
+}
+
+void DWaterProgressPrivate::updateFrameRate()
+{
+    D_Q(DWaterProgress);
+
+    // 未开始动画时没有注册到时钟，不会产生任何效果
+    DAnimationClock::setInterval(q, frameInterval());
 }
 
 void DWaterProgressPrivate::paint(QPainter *p)
@@ -292,24 +385,10 @@ void DWaterProgressPrivate::paint(QPainter *p)
     int yOffset = rect.toRect().topLeft().y() + (100 - value - 10)  * sz.height() / 100;
 
     // draw water
-    QImage waterImage = QImage(sz, QImage::Format_ARGB32_Premultiplied);
-    QPainter waterPinter(&waterImage);
+    QPainter waterPinter(&frameImage);
     waterPinter.setRenderHint(QPainter::Antialiasing);
     waterPinter.setCompositionMode(QPainter::CompositionMode_Source);
-
-    QPointF pointStart(sz.width() / 2, 0);
-    QPointF pointEnd(sz.width() / 2, sz.height());
-    QLinearGradient linear(pointStart, pointEnd);
-    QColor startColor("#1F08FF");
-    startColor.setAlphaF(1);
-    QColor endColor("#50FFF7");
-    endColor.setAlphaF(0.28);
-    linear.setColorAt(0, startColor);
-    linear.setColorAt(1, endColor);
-    linear.setSpread(QGradient::PadSpread);
-    waterPinter.setPen(Qt::NoPen);
-    waterPinter.setBrush(linear);
-    waterPinter.drawEllipse(waterImage.rect().center(), sz.width() / 2 + 1, sz.height() / 2  + 1);
+    waterPinter.drawImage(0, 0, backgroundImage);
 
     waterPinter.setCompositionMode(QPainter::CompositionMode_SourceOver);
     waterPinter.drawImage(static_cast<int>(backXOffset), yOffset, waterBackImage);
@@ -319,12 +398,12 @@ void DWaterProgressPrivate::paint(QPainter *p)
 
     //drwa pop
     if (value > 30) {
+        waterPinter.setPen(Qt::NoPen);
+        waterPinter.setBrush(QColor(255, 255, 255, 255 * 0.3));
+
         for (auto &pop : pops) {
-            QPainterPath popPath;
-            popPath.addEllipse(pop.xOffset * sz.width() / 100, (100 - pop.yOffset) * sz.height() / 100,
-                               pop.size * sz.width() / 100, pop.size * sz.height() / 100);
-            QColor color(255, 255, 255, 255 * 0.3);
-            waterPinter.fillPath(popPath, color);
+            waterPinter.drawEllipse(QRectF(pop.xOffset * sz.width() / 100, (100 - pop.yOffset) * sz.height() / 100,
+                                           pop.size * sz.width() / 100, pop.size * sz.height() / 100));
         }
     }
 
@@ -361,31 +440,14 @@ void DWaterProgressPrivate::paint(QPainter *p)
             waterPinter.drawText(rectPerent, Qt::AlignCenter, "%");
         }
     }
+
+    // 只保留圆形遮罩内的部分
+    waterPinter.setCompositionMode(QPainter::CompositionMode_DestinationIn);
+    waterPinter.drawImage(0, 0, maskImage);
     waterPinter.end();
 
-    QPixmap maskPixmap(sz);
-    maskPixmap.fill(Qt::transparent);
-    QPainterPath path;
-    path.addEllipse(QRectF(0, 0, sz.width(), sz.height()));
-    QPainter maskPainter(&maskPixmap);
-    maskPainter.setRenderHint(QPainter::Antialiasing);
-    maskPainter.setPen(QPen(Qt::white, 1));
-    maskPainter.fillPath(path, QBrush(Qt::white));
-
-    QPainter::CompositionMode mode = QPainter::CompositionMode_SourceIn;
-    QImage contentImage = QImage(sz, QImage::Format_ARGB32_Premultiplied);
-    QPainter contentPainter(&contentImage);
-    contentPainter.setCompositionMode(QPainter::CompositionMode_Source);
-    contentPainter.fillRect(contentImage.rect(), Qt::transparent);
-    contentPainter.setCompositionMode(QPainter::CompositionMode_SourceOver);
-    contentPainter.drawImage(0, 0, maskPixmap.toImage());
-    contentPainter.setCompositionMode(mode);
-    contentPainter.drawImage(0, 0, waterImage);
-    contentPainter.setCompositionMode(QPainter::CompositionMode_DestinationOver);
-    contentPainter.end();
-
-    contentImage.setDevicePixelRatio(pixelRatio);
-    p->drawImage(q->rect(), contentImage);
+    // frameImage 按设备像素绘制且跨帧复用，不设置 devicePixelRatio，由 drawImage 映射到逻辑区域
+    p->drawImage(q->rect(), frameImage);
 }
 
 DWIDGET_END_NAMESPACE
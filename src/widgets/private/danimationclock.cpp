@@ -0,0 +1,372 @@
+/*
+ * Copyright (C) 2020 ~ 2020 Deepin Technology Co., Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "danimationclock_p.h"
+
+#include <QAbstractAnimation>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QVector>
+#include <QWidget>
+#include <QWindow>
+#include <QEvent>
+#include <QTimerEvent>
+#include <QBasicTimer>
+
+#include <algorithm>
+
+DWIDGET_BEGIN_NAMESPACE
+
+// Hidden widgets are checked this often in milliseconds, events wake them up earlier.
+#define PAUSED_POLL_INTERVAL 1000
+// The animation timer is only kept running while a widget is due within this many milliseconds
+// (about two frames), slower widgets are woken up by a timer at their next tick.
+#define ANIMATION_TIMER_WINDOW 32
+
+class AnimationClockDriver : public QAbstractAnimation
+{
+public:
+    struct Client {
+        QPointer<QWidget> widget;
+        int interval;
+        qint64 nextTick;
+        bool paused;
+        DAnimationClock::TickFunction tick;
+        DAnimationClock::PauseFunction pause;
+    };
+
+    explicit AnimationClockDriver(QObject *parent)
+        : QAbstractAnimation(parent)
+    {
+        clock.start();
+    }
+
+    int duration() const override
+    {
+        return -1;
+    }
+
+    int indexOf(const QWidget *widget) const
+    {
+        for (int i = 0; i < clients.size(); ++i) {
+            if (clients.at(i).widget == widget)
+                return i;
+        }
+
+        return -1;
+    }
+
+    qint64 nextTick(int interval) const
+    {
+        return (clock.elapsed() / interval + 1) * interval;
+    }
+
+    void removeStoppedClients()
+    {
+        clients.erase(std::remove_if(clients.begin(), clients.end(), [] (const Client &client) {
+            return client.widget.isNull();
+        }), clients.end());
+    }
+
+    // 动画定时器每一帧都会唤醒进程，只在下一次更新不超过两帧时运行，
+    // 间隔较长或全部暂停时停止动画定时器，由 wakeTimer 在下一次更新时唤醒
+    void schedule()
+    {
+        qint64 due = -1;
+
+        for (const Client &client : clients) {
+            if (client.widget && (due < 0 || client.nextTick < due))
+                due = client.nextTick;
+        }
+
+        if (due < 0) {
+            wakeTimer.stop();
+            stop();
+            return;
+        }
+
+        const qint64 wait = due - clock.elapsed();
+
+        if (wait <= ANIMATION_TIMER_WINDOW) {
+            wakeTimer.stop();
+
+            if (state() == QAbstractAnimation::Paused) {
+                resume();
+            } else if (state() != QAbstractAnimation::Running) {
+                start();
+            }
+
+            return;
+        }
+
+        if (state() == QAbstractAnimation::Running)
+            pause();
+
+        wakeTimer.start(int(wait), Qt::PreciseTimer, this);
+    }
+
+    // 暂停的动画在下一次更新时重新检查是否可见，widget 为空时唤醒所有暂停的动画
+    void wakeUp(const QObject *widget = nullptr)
+    {
+        bool woken = false;
+
+        for (Client &client : clients) {
+            if (client.paused && (!widget || client.widget.data() == widget)) {
+                client.nextTick = 0;
+                woken = true;
+            }
+        }
+
+        if (woken)
+            schedule();
+    }
+
+    void watch(QWidget *widget)
+    {
+        widget->installEventFilter(this);
+        widget->window()->installEventFilter(this);
+
+        if (QWindow *window = widget->window()->windowHandle())
+            window->installEventFilter(this);
+    }
+
+    void unwatch(const QWidget *widget)
+    {
+        QWidget *target = const_cast<QWidget *>(widget);
+        QWidget *top_level = target->window();
+        target->removeEventFilter(this);
+
+        // 同一窗口中还有其它动画时保留窗口的事件过滤器
+        for (const Client &client : clients) {
+            if (client.widget && client.widget != widget && client.widget->window() == top_level)
+                return;
+        }
+
+        top_level->removeEventFilter(this);
+
+        if (QWindow *window = top_level->windowHandle())
+            window->removeEventFilter(this);
+    }
+
+    bool eventFilter(QObject *watched, QEvent *event) override
+    {
+        switch (event->type()) {
+        case QEvent::Show:
+            // 窗口第一次显示时才创建 QWindow
+            if (QWidget *widget = qobject_cast<QWidget *>(watched)) {
+                if (widget->isWindow() && widget->windowHandle())
+                    widget->windowHandle()->installEventFilter(this);
+            }
+            wakeUp();
+            break;
+        case QEvent::Expose:
+        case QEvent::WindowStateChange:
+            wakeUp();
+            break;
+        case QEvent::Paint:
+            // 暂停的控件被重绘说明它重新露出来了，其它控件的重绘不影响暂停的动画
+            wakeUp(watched);
+            break;
+        default:
+            break;
+        }
+
+        return QAbstractAnimation::eventFilter(watched, event);
+    }
+
+    QVector<Client> clients;
+    QElapsedTimer clock;
+    QBasicTimer wakeTimer;
+    bool ticking = false;
+
+protected:
+    void updateCurrentTime(int) override
+    {
+        advance();
+    }
+
+    void timerEvent(QTimerEvent *event) override
+    {
+        if (event->timerId() == wakeTimer.timerId()) {
+            wakeTimer.stop();
+            advance();
+            return;
+        }
+
+        QAbstractAnimation::timerEvent(event);
+    }
+
+private:
+    void advance();
+};
+
+void AnimationClockDriver::advance()
+{
+    const qint64 now = clock.elapsed();
+    // 只处理开始时已注册的动画，回调中注销的动画只做标记，结束后再移除
+    const int count = clients.size();
+
+    ticking = true;
+
+    for (int i = 0; i < count; ++i) {
+        if (clients.at(i).widget.isNull())
+            continue;
+
+        if (now < clients.at(i).nextTick)
+            continue;
+
+        Client &client = clients[i];
+        // 对齐到间隔的整数倍，间隔相同的动画总是在同一次更新中刷新
+        client.nextTick = (now / client.interval + 1) * client.interval;
+
+        const bool occluded = DAnimationClock::isOccluded(client.widget);
+
+        // 暂停的动画低频检查是否可见，事件会提前唤醒它们
+        if (occluded)
+            client.nextTick = now + PAUSED_POLL_INTERVAL;
+
+        if (occluded != client.paused) {
+            client.paused = occluded;
+
+            if (client.pause) {
+                // 回调中可能注册新的动画，不能继续使用 client 的引用
+                const DAnimationClock::PauseFunction pause = client.pause;
+                pause(occluded);
+            }
+        }
+
+        if (occluded || clients.at(i).widget.isNull() || !clients.at(i).tick)
+            continue;
+
+        const DAnimationClock::TickFunction tick = clients.at(i).tick;
+        tick();
+    }
+
+    ticking = false;
+    removeStoppedClients();
+    schedule();
+}
+
+// 时钟属于 qApp，应用程序退出时随之销毁
+static QPointer<AnimationClockDriver> clockDriver;
+
+static AnimationClockDriver *driver(bool create = false)
+{
+    if (!clockDriver && create && QCoreApplication::instance())
+        clockDriver = new AnimationClockDriver(QCoreApplication::instance());
+
+    return clockDriver;
+}
+
+void DAnimationClock::registerWidget(QWidget *widget, int interval, const TickFunction &tick, const PauseFunction &pause)
+{
+    AnimationClockDriver *clock = driver(true);
+
+    if (!clock || !widget)
+        return;
+
+    interval = qMax(1, interval);
+    int index = clock->indexOf(widget);
+
+    if (index < 0) {
+        AnimationClockDriver::Client client;
+        client.widget = widget;
+        client.paused = false;
+        clock->clients.append(client);
+        index = clock->clients.size() - 1;
+    }
+
+    AnimationClockDriver::Client &client = clock->clients[index];
+    client.interval = interval;
+    client.nextTick = clock->nextTick(interval);
+    client.tick = tick;
+    client.pause = pause;
+
+    clock->watch(widget);
+    clock->schedule();
+}
+
+void DAnimationClock::unregisterWidget(const QWidget *widget)
+{
+    AnimationClockDriver *clock = driver();
+
+    if (!clock)
+        return;
+
+    int index = clock->indexOf(widget);
+
+    if (index < 0)
+        return;
+
+    clock->unwatch(widget);
+
+    if (clock->ticking) {
+        clock->clients[index].widget = nullptr;
+        return;
+    }
+
+    clock->clients.removeAt(index);
+    clock->schedule();
+}
+
+bool DAnimationClock::isRegistered(const QWidget *widget)
+{
+    AnimationClockDriver *clock = driver();
+
+    return clock && clock->indexOf(widget) >= 0;
+}
+
+void DAnimationClock::setInterval(const QWidget *widget, int interval)
+{
+    AnimationClockDriver *clock = driver();
+
+    if (!clock)
+        return;
+
+    int index = clock->indexOf(widget);
+
+    if (index < 0)
+        return;
+
+    interval = qMax(1, interval);
+    AnimationClockDriver::Client &client = clock->clients[index];
+
+    if (client.interval == interval)
+        return;
+
+    client.interval = interval;
+    client.nextTick = clock->nextTick(interval);
+
+    if (!clock->ticking)
+        clock->schedule();
+}
+
+bool DAnimationClock::isOccluded(const QWidget *widget)
+{
+    if (!widget || !widget->isVisible())
+        return true;
+
+    const QWindow *window = widget->window()->windowHandle();
+
+    if (window && (!window->isExposed() || window->visibility() == QWindow::Minimized))
+        return true;
+
+    return widget->visibleRegion().isEmpty();
+}
+
+DWIDGET_END_NAMESPACE
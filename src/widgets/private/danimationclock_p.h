@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2020 ~ 2020 Deepin Technology Co., Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DANIMATIONCLOCK_P_H
+#define DANIMATIONCLOCK_P_H
+
+#include <dtkwidget_global.h>
+
+#include <QtGlobal>
+
+#include <functional>
+
+QT_BEGIN_NAMESPACE
+class QWidget;
+QT_END_NAMESPACE
+
+DWIDGET_BEGIN_NAMESPACE
+
+/*
+ * Process wide clock of the animated widgets (DSpinner, DWaterProgress, DPictureSequenceView and
+ * DLoadingIndicator). The clock is driven by the Qt animation timer, so it ticks in the same frame
+ * as every QAbstractAnimation and follows a vsync animation driver when one is installed.
+ * Ticks are aligned to multiples of the interval, widgets using the same interval are updated
+ * in the same batch and their repaints are merged into one backing store flush.
+ * Hidden, minimized or fully covered widgets are paused until they become visible again, the
+ * clock stops when all widgets are paused and wakes up on show, expose and window state events.
+ * The animation timer only runs while a widget is due within about two frames, widgets with longer
+ * intervals are woken up by a timer, so they do not cost a wakeup per frame.
+ */
+class DAnimationClock
+{
+public:
+    typedef std::function<void()> TickFunction;
+    typedef std::function<void(bool paused)> PauseFunction;
+
+    // Register again to change the interval or the functions, the interval is in milliseconds.
+    // pause is called when the widget is paused or resumed because of its visibility.
+    static void registerWidget(QWidget *widget, int interval, const TickFunction &tick,
+                               const PauseFunction &pause = PauseFunction());
+    static void unregisterWidget(const QWidget *widget);
+    static bool isRegistered(const QWidget *widget);
+    static void setInterval(const QWidget *widget, int interval);
+
+    static bool isOccluded(const QWidget *widget);
+};
+
+DWIDGET_END_NAMESPACE
+
+#endif // DANIMATIONCLOCK_P_H
@@ -42,11 +42,28 @@ public:
 
     bool full = false;
     bool blurEnabled = true;
+    DBlurEffectWidget::BlurQuality blurQuality = DBlurEffectWidget::AutoQuality;
 
     QColor maskColor = Qt::transparent;
     DBlurEffectWidget::MaskColorType maskColorType = DBlurEffectWidget::AutoColor;
     QPainterPath maskPath;
 
+    // 模糊结果按图块缓存，图块的源图像内容变化时才重新模糊
+    struct BlurTile {
+        QImage image;
+        quint32 generation = 1;
+        quint32 blurredGeneration = 0;
+        // 图块对应的源图像区域的哈希，重新获取源图像后用于判断哪些区域变化了
+        uint sourceHash = 0;
+        bool sourceHashValid = false;
+    };
+
+    QVector<BlurTile> blurTiles;
+    QSize blurTilesSize;
+    int blurTilesRadius = -1;
+    int blurTilesDownsample = 1;
+    int blurTileColumns = 0;
+
     // group
     DBlurEffectGroup *group = nullptr;
 
@@ -57,16 +74,29 @@ public:
     void removeFromBlurEffectWidgetHash();
 
     bool updateWindowBlurArea();
+    void requestWindowBlurAreaUpdate();
     void setMaskColor(const QColor &color);
     void setMaskAlpha(const quint8 alpha);
     quint8 getMaskColorAlpha() const;
+    static int downsampleFactor(DBlurEffectWidget::BlurQuality quality, qreal pixelRadius);
     QColor getMaskColor(const QColor &baseColor) const;
 
     void resetSourceImage();
+    void updateSourceImage(const QPoint &pos, const QImage &image, const QRect &rect);
+    int blurTileMargin() const;
+    QRect blurTileSourceRect(int index) const;
+    uint blurTileSourceHash(int index) const;
+    void updateBlurTileSourceHashes();
+    void markBlurTilesDirty(const QRect &sourceRect);
+    void markChangedBlurTiles();
+    void paintBlurTiles(QPainter *pa, const QRegion &region);
 
     static QMultiHash<QWidget*, const DBlurEffectWidget*> blurEffectWidgetHash;
     static QHash<const DBlurEffectWidget*, QWidget*> windowOfBlurEffectHash;
     static bool updateWindowBlurArea(QWidget *topLevelWidget);
+    // 合并同一次事件循环内的更新，每个顶层窗口只提交一次模糊区域
+    static void requestWindowBlurAreaUpdate(QWidget *topLevelWidget, bool force = false);
+    static void flushWindowBlurAreaUpdates();
 
 private:
     D_DECLARE_PUBLIC(DBlurEffectWidget)
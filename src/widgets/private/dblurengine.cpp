@@ -0,0 +1,682 @@
+/*
+ * Copyright (C) 2020 ~ 2020 Deepin Technology Co., Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "dblurengine_p.h"
+
+#include <QAtomicInt>
+#include <QThread>
+#include <QVector>
+#include <QtConcurrent/QtConcurrent>
+
+#include <private/qsimd_p.h>
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define D_BLUR_NEON
+#endif
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+DWIDGET_BEGIN_NAMESPACE
+
+// Images from this many pixels are blurred on multiple threads.
+#define CONCURRENT_BLUR_MIN_PIXELS (256 * 256)
+// Vertical pass splits columns into stripes aligned to this many bytes.
+#define VERTICAL_STRIPE_ALIGN 32
+
+typedef void (*HorizontalPass)(const uchar *src, uchar *dst, int width, int radius, float scale);
+typedef void (*VerticalPass)(const uchar *src, int srcStride, uchar *dst, int dstStride,
+                             int height, int bytes, int radius, float scale, qint32 *sums);
+
+static inline uchar roundToByte(float value)
+{
+    // Same rounding as the cvtps2dq/fcvtns of the simd kernels, round half to even.
+    return uchar(qBound(0, int(std::nearbyint(value)), 255));
+}
+
+static void horizontalPassScalar(const uchar *src, uchar *dst, int width, int channels, int radius, float scale)
+{
+    for (int c = 0; c < channels; ++c) {
+        int sum = 0;
+
+        for (int i = -radius; i <= radius; ++i)
+            sum += src[qBound(0, i, width - 1) * channels + c];
+
+        for (int x = 0; x < width; ++x) {
+            dst[x * channels + c] = roundToByte(float(sum) * scale);
+            sum += src[qMin(x + radius + 1, width - 1) * channels + c] - src[qMax(x - radius, 0) * channels + c];
+        }
+    }
+}
+
+static void horizontalPassScalar4(const uchar *src, uchar *dst, int width, int radius, float scale)
+{
+    horizontalPassScalar(src, dst, width, 4, radius, scale);
+}
+
+static void initColumnSums(const uchar *src, int srcStride, int height, int bytes, int radius, qint32 *sums)
+{
+    memset(sums, 0, sizeof(qint32) * bytes);
+
+    for (int i = -radius; i <= radius; ++i) {
+        const uchar *line = src + qBound(0, i, height - 1) * srcStride;
+
+        for (int j = 0; j < bytes; ++j)
+            sums[j] += line[j];
+    }
+}
+
+static inline void verticalPassTail(const uchar *add, const uchar *sub, uchar *out, int begin, int bytes, float scale, qint32 *sums)
+{
+    for (int i = begin; i < bytes; ++i) {
+        out[i] = roundToByte(float(sums[i]) * scale);
+        sums[i] += add[i] - sub[i];
+    }
+}
+
+static void verticalPassScalar(const uchar *src, int srcStride, uchar *dst, int dstStride,
+                               int height, int bytes, int radius, float scale, qint32 *sums)
+{
+    initColumnSums(src, srcStride, height, bytes, radius, sums);
+
+    for (int y = 0; y < height; ++y) {
+        verticalPassTail(src + qMin(y + radius + 1, height - 1) * srcStride,
+                         src + qMax(y - radius, 0) * srcStride,
+                         dst + y * dstStride, 0, bytes, scale, sums);
+    }
+}
+
+#if defined(__SSE2__)
+static inline __m128i loadPixelSSE2(const quint32 *pixel)
+{
+    const __m128i zero = _mm_setzero_si128();
+
+    return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(int(*pixel)), zero), zero);
+}
+
+static inline __m128i load4BytesSSE2(const uchar *bytes)
+{
+    int value;
+    memcpy(&value, bytes, sizeof(value));
+
+    const __m128i zero = _mm_setzero_si128();
+
+    return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(value), zero), zero);
+}
+
+static inline __m128i packSumsSSE2(__m128i sum, __m128 factor)
+{
+    __m128i value = _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(sum), factor));
+    value = _mm_packs_epi32(value, value);
+
+    return _mm_packus_epi16(value, value);
+}
+
+static void horizontalPassSSE2(const uchar *src, uchar *dst, int width, int radius, float scale)
+{
+    const quint32 *in = reinterpret_cast<const quint32 *>(src);
+    const __m128 factor = _mm_set1_ps(scale);
+    __m128i sum = _mm_setzero_si128();
+
+    for (int i = -radius; i <= radius; ++i)
+        sum = _mm_add_epi32(sum, loadPixelSSE2(in + qBound(0, i, width - 1)));
+
+    for (int x = 0; x < width; ++x) {
+        const int value = _mm_cvtsi128_si32(packSumsSSE2(sum, factor));
+        memcpy(dst + x * 4, &value, sizeof(value));
+
+        sum = _mm_add_epi32(sum, _mm_sub_epi32(loadPixelSSE2(in + qMin(x + radius + 1, width - 1)),
+                                               loadPixelSSE2(in + qMax(x - radius, 0))));
+    }
+}
+
+static void verticalPassSSE2(const uchar *src, int srcStride, uchar *dst, int dstStride,
+                             int height, int bytes, int radius, float scale, qint32 *sums)
+{
+    const __m128 factor = _mm_set1_ps(scale);
+
+    initColumnSums(src, srcStride, height, bytes, radius, sums);
+
+    for (int y = 0; y < height; ++y) {
+        const uchar *add = src + qMin(y + radius + 1, height - 1) * srcStride;
+        const uchar *sub = src + qMax(y - radius, 0) * srcStride;
+        uchar *out = dst + y * dstStride;
+        int i = 0;
+
+        for (; i + 4 <= bytes; i += 4) {
+            __m128i sum = _mm_loadu_si128(reinterpret_cast<const __m128i *>(sums + i));
+            const int value = _mm_cvtsi128_si32(packSumsSSE2(sum, factor));
+            memcpy(out + i, &value, sizeof(value));
+
+            sum = _mm_add_epi32(sum, _mm_sub_epi32(load4BytesSSE2(add + i), load4BytesSSE2(sub + i)));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(sums + i), sum);
+        }
+
+        verticalPassTail(add, sub, out, i, bytes, scale, sums);
+    }
+}
+#endif
+
+#if defined(__SSE2__)
+#if QT_COMPILER_SUPPORTS_HERE(AVX2)
+QT_FUNCTION_TARGET(AVX2)
+static void verticalPassAVX2(const uchar *src, int srcStride, uchar *dst, int dstStride,
+                             int height, int bytes, int radius, float scale, qint32 *sums)
+{
+    const __m256 factor = _mm256_set1_ps(scale);
+
+    initColumnSums(src, srcStride, height, bytes, radius, sums);
+
+    for (int y = 0; y < height; ++y) {
+        const uchar *add = src + qMin(y + radius + 1, height - 1) * srcStride;
+        const uchar *sub = src + qMax(y - radius, 0) * srcStride;
+        uchar *out = dst + y * dstStride;
+        int i = 0;
+
+        for (; i + 8 <= bytes; i += 8) {
+            __m256i sum = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(sums + i));
+            const __m256i value = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_cvtepi32_ps(sum), factor));
+            __m128i packed = _mm_packs_epi32(_mm256_castsi256_si128(value), _mm256_extracti128_si256(value, 1));
+            packed = _mm_packus_epi16(packed, packed);
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(out + i), packed);
+
+            const __m256i added = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(add + i)));
+            const __m256i subtracted = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(sub + i)));
+            sum = _mm256_add_epi32(sum, _mm256_sub_epi32(added, subtracted));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(sums + i), sum);
+        }
+
+        verticalPassTail(add, sub, out, i, bytes, scale, sums);
+    }
+}
+#endif
+#endif
+
+#ifdef D_BLUR_NEON
+static inline int32x4_t loadPixelNEON(const quint32 *pixel)
+{
+    const uint8x8_t bytes = vreinterpret_u8_u32(vdup_n_u32(*pixel));
+
+    return vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(vmovl_u8(bytes))));
+}
+
+static void horizontalPassNEON(const uchar *src, uchar *dst, int width, int radius, float scale)
+{
+    const quint32 *in = reinterpret_cast<const quint32 *>(src);
+    int32x4_t sum = vdupq_n_s32(0);
+
+    for (int i = -radius; i <= radius; ++i)
+        sum = vaddq_s32(sum, loadPixelNEON(in + qBound(0, i, width - 1)));
+
+    for (int x = 0; x < width; ++x) {
+        const int16x4_t value = vqmovn_s32(vcvtnq_s32_f32(vmulq_n_f32(vcvtq_f32_s32(sum), scale)));
+        const quint32 packed = vget_lane_u32(vreinterpret_u32_u8(vqmovun_s16(vcombine_s16(value, value))), 0);
+        memcpy(dst + x * 4, &packed, sizeof(packed));
+
+        sum = vaddq_s32(sum, vsubq_s32(loadPixelNEON(in + qMin(x + radius + 1, width - 1)),
+                                       loadPixelNEON(in + qMax(x - radius, 0))));
+    }
+}
+
+static void verticalPassNEON(const uchar *src, int srcStride, uchar *dst, int dstStride,
+                             int height, int bytes, int radius, float scale, qint32 *sums)
+{
+    initColumnSums(src, srcStride, height, bytes, radius, sums);
+
+    for (int y = 0; y < height; ++y) {
+        const uchar *add = src + qMin(y + radius + 1, height - 1) * srcStride;
+        const uchar *sub = src + qMax(y - radius, 0) * srcStride;
+        uchar *out = dst + y * dstStride;
+        int i = 0;
+
+        for (; i + 8 <= bytes; i += 8) {
+            int32x4_t low = vld1q_s32(sums + i);
+            int32x4_t high = vld1q_s32(sums + i + 4);
+            const int16x4_t low_value = vqmovn_s32(vcvtnq_s32_f32(vmulq_n_f32(vcvtq_f32_s32(low), scale)));
+            const int16x4_t high_value = vqmovn_s32(vcvtnq_s32_f32(vmulq_n_f32(vcvtq_f32_s32(high), scale)));
+            vst1_u8(out + i, vqmovun_s16(vcombine_s16(low_value, high_value)));
+
+            const int16x8_t diff = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(add + i))),
+                                             vreinterpretq_s16_u16(vmovl_u8(vld1_u8(sub + i))));
+            vst1q_s32(sums + i, vaddw_s16(low, vget_low_s16(diff)));
+            vst1q_s32(sums + i + 4, vaddw_s16(high, vget_high_s16(diff)));
+        }
+
+        verticalPassTail(add, sub, out, i, bytes, scale, sums);
+    }
+}
+#endif
+
+static DBlurEngine::InstructionSet detectInstructionSet()
+{
+#if defined(__SSE2__)
+#if QT_COMPILER_SUPPORTS_HERE(AVX2)
+    if (qCpuHasFeature(AVX2))
+        return DBlurEngine::AVX2;
+#endif
+    return DBlurEngine::SSE2;
+#elif defined(D_BLUR_NEON)
+    return DBlurEngine::NEON;
+#else
+    return DBlurEngine::Scalar;
+#endif
+}
+
+static HorizontalPass horizontalPass(DBlurEngine::InstructionSet set)
+{
+    switch (set) {
+#if defined(__SSE2__)
+    // AVX2 gains nothing for one pixel of the horizontal pass
+    case DBlurEngine::AVX2:
+    case DBlurEngine::SSE2:
+        return horizontalPassSSE2;
+#endif
+#ifdef D_BLUR_NEON
+    case DBlurEngine::NEON:
+        return horizontalPassNEON;
+#endif
+    default:
+        return horizontalPassScalar4;
+    }
+}
+
+static VerticalPass verticalPass(DBlurEngine::InstructionSet set)
+{
+    switch (set) {
+#if defined(__SSE2__)
+#if QT_COMPILER_SUPPORTS_HERE(AVX2)
+    case DBlurEngine::AVX2:
+        return verticalPassAVX2;
+#endif
+    case DBlurEngine::SSE2:
+        return verticalPassSSE2;
+#endif
+#ifdef D_BLUR_NEON
+    case DBlurEngine::NEON:
+        return verticalPassNEON;
+#endif
+    default:
+        return verticalPassScalar;
+    }
+}
+
+// Box radii of three box blurs approximating a gaussian blur with sigma.
+static void boxRadiiForGauss(qreal sigma, int radii[3])
+{
+    const int n = 3;
+    const qreal ideal_width = std::sqrt(12 * sigma * sigma / n + 1);
+    int lower_width = qMax(1, int(std::floor(ideal_width)));
+
+    if (lower_width % 2 == 0)
+        --lower_width;
+
+    const int upper_width = lower_width + 2;
+    const qreal ideal_count = (12 * sigma * sigma - n * lower_width * lower_width - 4 * n * lower_width - 3 * n)
+                              / (-4 * lower_width - 4);
+    const int lower_count = qRound(ideal_count);
+
+    for (int i = 0; i < n; ++i)
+        radii[i] = ((i < lower_count ? lower_width : upper_width) - 1) / 2;
+
+    // Small radii round down to empty boxes, keep one pass so the image is still blurred
+    if (sigma > 0 && radii[n - 1] < 1)
+        radii[n - 1] = 1;
+}
+
+template <typename Function>
+static void forEachRange(int count, int align, bool concurrent, Function function)
+{
+    const int range_count = concurrent ? qMin(QThread::idealThreadCount(), count / align) : 1;
+
+    if (range_count < 2) {
+        function(0, count);
+        return;
+    }
+
+    QVector<QPair<int, int>> ranges;
+    for (int i = 0; i < range_count; ++i) {
+        const int begin = count / align * i / range_count * align;
+        const int end = i + 1 == range_count ? count : count / align * (i + 1) / range_count * align;
+        ranges << qMakePair(begin, end);
+    }
+
+    QtConcurrent::blockingMap(ranges, [&function](const QPair<int, int> &range) {
+        function(range.first, range.second);
+    });
+}
+
+static void blurPlane(uchar *bits, int stride, int width, int height, int channels, const int radii[3],
+                      DBlurEngine::InstructionSet set)
+{
+    const HorizontalPass horizontal = horizontalPass(set);
+    const VerticalPass vertical = verticalPass(set);
+    const bool concurrent = qint64(width) * height >= CONCURRENT_BLUR_MIN_PIXELS;
+    const int bytes = width * channels;
+
+    // Rows are independent in the horizontal passes.
+    forEachRange(height, 1, concurrent, [&](int begin, int end) {
+        std::vector<uchar> line(bytes);
+
+        for (int y = begin; y < end; ++y) {
+            uchar *from = bits + y * stride;
+            uchar *to = line.data();
+
+            for (int i = 0; i < 3; ++i) {
+                if (radii[i] <= 0)
+                    continue;
+
+                const float scale = 1.0f / (2 * radii[i] + 1);
+
+                if (channels == 4)
+                    horizontal(from, to, width, radii[i], scale);
+                else
+                    horizontalPassScalar(from, to, width, channels, radii[i], scale);
+
+                std::swap(from, to);
+            }
+
+            if (from != bits + y * stride)
+                memcpy(bits + y * stride, from, bytes);
+        }
+    });
+
+    // Columns are independent in the vertical passes, every stripe has its own column sums.
+    std::vector<uchar> buffer(size_t(stride) * height);
+
+    forEachRange(bytes, VERTICAL_STRIPE_ALIGN, concurrent, [&](int begin, int end) {
+        std::vector<qint32> sums(end - begin);
+        uchar *from = bits + begin;
+        uchar *to = buffer.data() + begin;
+
+        for (int i = 0; i < 3; ++i) {
+            if (radii[i] <= 0)
+                continue;
+
+            vertical(from, stride, to, stride, height, end - begin, radii[i], 1.0f / (2 * radii[i] + 1), sums.data());
+            std::swap(from, to);
+        }
+
+        if (from != bits + begin) {
+            for (int y = 0; y < height; ++y)
+                memcpy(bits + y * stride + begin, from + y * stride, end - begin);
+        }
+    });
+}
+
+#ifdef QT_DEBUG
+// Blur a fixed pattern with the kernels of set and the scalar kernels, the results must be same.
+// Odd sizes and radii make every kernel run its tail loop too.
+static bool matchesScalar(DBlurEngine::InstructionSet set)
+{
+    const int width = 67;
+    const int height = 45;
+    const int radii[3] = {3, 4, 4};
+
+    for (int channels : {1, 4}) {
+        const int stride = (width * channels + 3) & ~3;
+        std::vector<uchar> reference(size_t(stride) * height);
+
+        for (size_t i = 0; i < reference.size(); ++i)
+            reference[i] = uchar((i * 7919) ^ (i >> 3));
+
+        std::vector<uchar> result = reference;
+
+        blurPlane(reference.data(), stride, width, height, channels, radii, DBlurEngine::Scalar);
+        blurPlane(result.data(), stride, width, height, channels, radii, set);
+
+        if (reference != result)
+            return false;
+    }
+
+    return true;
+}
+#endif
+
+// setInstructionSet() may run while pool threads blur images
+static QAtomicInt &instructionSetValue()
+{
+    static QAtomicInt set([] {
+        DBlurEngine::InstructionSet detected = detectInstructionSet();
+#ifdef QT_DEBUG
+        if (detected != DBlurEngine::Scalar && !matchesScalar(detected)) {
+            qWarning("DBlurEngine: simd kernels %d differ from the scalar kernels, use the scalar kernels", int(detected));
+            detected = DBlurEngine::Scalar;
+        }
+#endif
+        return int(detected);
+    }());
+
+    return set;
+}
+
+static DBlurEngine::InstructionSet currentInstructionSet()
+{
+    return DBlurEngine::InstructionSet(instructionSetValue().loadAcquire());
+}
+
+// Every pixel of the small plane is the average of a factor x factor block, blocks on the
+// right and bottom edges may be smaller.
+static void downsamplePlane(const uchar *src, int srcStride, int width, int height, int channels, int factor,
+                            uchar *dst, int dstStride, int dstWidth, int dstHeight)
+{
+    const bool concurrent = qint64(width) * height >= CONCURRENT_BLUR_MIN_PIXELS;
+
+    forEachRange(dstHeight, 1, concurrent, [&](int begin, int end) {
+        std::vector<quint32> sums(dstWidth * channels);
+
+        for (int y = begin; y < end; ++y) {
+            const int top = y * factor;
+            const int bottom = qMin(top + factor, height);
+
+            std::fill(sums.begin(), sums.end(), 0);
+
+            for (int sy = top; sy < bottom; ++sy) {
+                const uchar *line = src + sy * srcStride;
+
+                for (int x = 0; x < width; ++x) {
+                    quint32 *sum = sums.data() + x / factor * channels;
+
+                    for (int c = 0; c < channels; ++c)
+                        sum[c] += line[x * channels + c];
+                }
+            }
+
+            uchar *out = dst + y * dstStride;
+
+            for (int x = 0; x < dstWidth; ++x) {
+                const quint32 count = quint32(qMin((x + 1) * factor, width) - x * factor) * (bottom - top);
+
+                for (int c = 0; c < channels; ++c)
+                    out[x * channels + c] = uchar((sums[x * channels + c] + count / 2) / count);
+            }
+        }
+    });
+}
+
+// Source position of every destination pixel in 8bit fixed point, pixel centers are aligned.
+static void upsampleCoordinates(int length, int srcLength, int factor, std::vector<int> &index, std::vector<int> &weight)
+{
+    index.resize(length);
+    weight.resize(length);
+
+    for (int i = 0; i < length; ++i) {
+        const int pos = ((2 * i + 1 - factor) * 256) / (2 * factor);
+
+        if (pos <= 0) {
+            index[i] = 0;
+            weight[i] = 0;
+        } else if (pos >= (srcLength - 1) * 256) {
+            index[i] = srcLength - 1;
+            weight[i] = 0;
+        } else {
+            index[i] = pos >> 8;
+            weight[i] = pos & 0xff;
+        }
+    }
+}
+
+// Bilinear upsampling, the rows of the small plane are interpolated horizontally once and shared
+// by all destination rows between them.
+static void upsamplePlane(const uchar *src, int srcStride, int srcWidth, int srcHeight, int channels, int factor,
+                          uchar *dst, int dstStride, int width, int height)
+{
+    std::vector<int> x_index, x_weight, y_index, y_weight;
+    upsampleCoordinates(width, srcWidth, factor, x_index, x_weight);
+    upsampleCoordinates(height, srcHeight, factor, y_index, y_weight);
+
+    const bool concurrent = qint64(width) * height >= CONCURRENT_BLUR_MIN_PIXELS;
+    const int bytes = width * channels;
+
+    forEachRange(height, 1, concurrent, [&](int begin, int end) {
+        std::vector<quint16> lines[2] = {std::vector<quint16>(bytes), std::vector<quint16>(bytes)};
+        int line_rows[2] = {-1, -1};
+
+        auto interpolateRow = [&](int row, std::vector<quint16> &line) {
+            const uchar *in = src + row * srcStride;
+
+            for (int x = 0; x < width; ++x) {
+                const uchar *left = in + x_index[x] * channels;
+                const uchar *right = x_index[x] + 1 < srcWidth ? left + channels : left;
+                const int w = x_weight[x];
+
+                for (int c = 0; c < channels; ++c)
+                    line[x * channels + c] = quint16(left[c] * (256 - w) + right[c] * w);
+            }
+        };
+
+        for (int y = begin; y < end; ++y) {
+            const int rows[2] = {y_index[y], qMin(y_index[y] + 1, srcHeight - 1)};
+
+            for (int i = 0; i < 2; ++i) {
+                if (line_rows[i] == rows[i])
+                    continue;
+
+                // The next top row is usually the previous bottom row.
+                if (i == 0 && line_rows[1] == rows[0]) {
+                    std::swap(lines[0], lines[1]);
+                    std::swap(line_rows[0], line_rows[1]);
+
+                    if (line_rows[0] == rows[0])
+                        continue;
+                }
+
+                interpolateRow(rows[i], lines[i]);
+                line_rows[i] = rows[i];
+            }
+
+            const quint32 w = quint32(y_weight[y]);
+            uchar *out = dst + y * dstStride;
+
+            for (int i = 0; i < bytes; ++i)
+                out[i] = uchar((lines[0][i] * (256 - w) + lines[1][i] * w + 32768) >> 16);
+        }
+    });
+}
+
+static void blurImagePlane(QImage &image, int channels, qreal radius, int downsample)
+{
+    int radii[3];
+
+    if (downsample <= 1) {
+        // qt_blurImage looks about as strong as a gaussian blur with half radius as sigma
+        boxRadiiForGauss(radius / 2, radii);
+        blurPlane(image.bits(), image.bytesPerLine(), image.width(), image.height(), channels, radii, currentInstructionSet());
+
+        return;
+    }
+
+    const int width = (image.width() + downsample - 1) / downsample;
+    const int height = (image.height() + downsample - 1) / downsample;
+    const int stride = (width * channels + 3) & ~3;
+    std::vector<uchar> small(size_t(stride) * height);
+
+    downsamplePlane(image.constBits(), image.bytesPerLine(), image.width(), image.height(), channels, downsample,
+                    small.data(), stride, width, height);
+    boxRadiiForGauss(radius / downsample / 2, radii);
+    blurPlane(small.data(), stride, width, height, channels, radii, currentInstructionSet());
+    upsamplePlane(small.data(), stride, width, height, channels, downsample,
+                  image.bits(), image.bytesPerLine(), image.width(), image.height());
+}
+
+int DBlurEngine::downsampleFactor(qreal pixelRadius, bool preferPerformance)
+{
+    if (preferPerformance && pixelRadius >= 10)
+        return 4;
+
+    // Same as qt_blurImage, which blurs a half scaled image from radius 4
+    return pixelRadius >= 4 ? 2 : 1;
+}
+
+DBlurEngine::InstructionSet DBlurEngine::supportedInstructionSet()
+{
+    return detectInstructionSet();
+}
+
+DBlurEngine::InstructionSet DBlurEngine::instructionSet()
+{
+    return currentInstructionSet();
+}
+
+void DBlurEngine::setInstructionSet(DBlurEngine::InstructionSet set)
+{
+    const InstructionSet supported = supportedInstructionSet();
+
+    if (set == Scalar || set == supported || (set == SSE2 && supported == AVX2))
+        instructionSetValue().storeRelease(int(set));
+}
+
+void DBlurEngine::blur(QImage &image, qreal radius, bool alphaOnly, int downsample)
+{
+    if (image.isNull() || radius < 1)
+        return;
+
+    // The small image must keep at least one pixel of blur radius
+    downsample = qBound(1, downsample, qMax(1, int(radius)));
+
+    if (alphaOnly) {
+        QImage alpha = image.convertToFormat(QImage::Format_Alpha8);
+        blurImagePlane(alpha, 1, radius, downsample);
+        image = alpha.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+        return;
+    }
+
+    switch (image.format()) {
+    case QImage::Format_Alpha8:
+    case QImage::Format_Grayscale8:
+        blurImagePlane(image, 1, radius, downsample);
+        break;
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32_Premultiplied:
+    case QImage::Format_RGBX8888:
+    case QImage::Format_RGBA8888_Premultiplied:
+        blurImagePlane(image, 4, radius, downsample);
+        break;
+    default: {
+        // Blur non-premultiplied colors would bleed colors of transparent pixels.
+        const QImage::Format format = image.format();
+        image = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+        blurImagePlane(image, 4, radius, downsample);
+        image = image.convertToFormat(format);
+        break;
+    }
+    }
+}
+
+DWIDGET_END_NAMESPACE
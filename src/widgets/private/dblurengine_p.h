@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2020 ~ 2020 Deepin Technology Co., Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DBLURENGINE_P_H
+#define DBLURENGINE_P_H
+
+#include <dtkwidget_global.h>
+
+#include <QImage>
+
+DWIDGET_BEGIN_NAMESPACE
+
+/*
+ * Blur used by DBlurEffectWidget, DBlurEffectGroup, DGraphicsGlowEffect and the drop shadows.
+ * A gaussian blur is approximated by three box blurs, every box blur is separated into a
+ * horizontal and a vertical pass. Kernels are selected at runtime by the instruction set of cpu,
+ * big images are blurred on multiple threads.
+ */
+class DBlurEngine
+{
+public:
+    // With QT_DEBUG, the detected kernels are checked against Scalar once and Scalar is used if they differ.
+    enum InstructionSet {
+        Scalar,     // reference implementation, other kernels give the same result
+        SSE2,
+        AVX2,
+        NEON
+    };
+
+    static InstructionSet supportedInstructionSet();
+    static InstructionSet instructionSet();
+    // Unsupported instruction set is ignored, Scalar always works.
+    static void setInstructionSet(InstructionSet set);
+
+    // Blur the image in place, the radius is same as the radius of qt_blurImage.
+    // RGB32 and premultiplied 32bit images are blurred directly, Alpha8 and Grayscale8 images
+    // are blurred as one channel, other formats are blurred as ARGB32_Premultiplied and converted
+    // back to their format, which loses some precision of translucent colors.
+    // With alphaOnly, the image becomes a black ARGB32_Premultiplied image with blurred alpha.
+    // With downsample greater than 1, a 1/downsample scaled copy is blurred and upsampled with
+    // bilinear filtering, it looks the same for big radius and costs much less.
+    static void blur(QImage &image, qreal radius, bool alphaOnly = false, int downsample = 1);
+    // Downsample factor for the radius in image pixels, that is radius x devicePixelRatio.
+    // Same as qt_blurImage by default, half scaled from radius 4. preferPerformance uses quarter
+    // scaled images for big radius, pass 1 to blur for the full quality of a full sized blur.
+    static int downsampleFactor(qreal pixelRadius, bool preferPerformance = false);
+};
+
+DWIDGET_END_NAMESPACE
+
+#endif // DBLURENGINE_P_H
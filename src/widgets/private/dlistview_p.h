@@ -33,6 +33,8 @@ class DListViewPrivate : public DTK_CORE_NAMESPACE::DObjectPrivate
     void init();
 
     void onOrientationChanged();
+    int laidOutRowCount() const;
+    void updateLayoutProgress();
 
     DBoxWidget *headerLayout = nullptr;
     DBoxWidget *footerLayout = nullptr;
@@ -40,6 +42,9 @@ class DListViewPrivate : public DTK_CORE_NAMESPACE::DObjectPrivate
     QList<QWidget*> headerList;
     QList<QWidget*> footerList;
 
+    // 分批布局时上一次通知的已布局行数
+    int layoutProgress = -1;
+
 #if(QT_VERSION < 0x050500)
     int left = 0, top = 0, right = 0, bottom = 0; // viewport margin
 #endif
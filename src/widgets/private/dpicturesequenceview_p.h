@@ -24,7 +24,6 @@
 
 #include <QList>
 #include <QGraphicsScene>
-#include <QTimer>
 
 DWIDGET_BEGIN_NAMESPACE
 
@@ -38,6 +37,7 @@ public:
 
     void init();
     void play();
+    void pause();
 
     QPixmap loadPixmap(const QString &path);
 
@@ -47,9 +47,10 @@ public:
 public:
     int lastItemPos = 0;
     bool singleShot = false;
+    // 刷新间隔，动画由所有动画控件共用的时钟驱动
+    int speed = 33;
 
     QGraphicsScene *scene;
-    QTimer *refreshTimer;
     QList<QGraphicsPixmapItem*> pictureItemList;
 };
 
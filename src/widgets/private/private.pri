@@ -54,7 +54,11 @@ HEADERS += \
     $$PWD/dsearchcombobox_p.h \
     $$PWD/dprintpreviewdialog_p.h \
     $$PWD/dprintpreviewwidget_p.h \
-    $$PWD/dpalettehelper_p.h
+    $$PWD/dpalettehelper_p.h \
+    $$PWD/dblurengine_p.h \
+    $$PWD/danimationclock_p.h
 
 SOURCES += \
-    $$PWD/dthemehelper.cpp
+    $$PWD/dthemehelper.cpp \
+    $$PWD/dblurengine.cpp \
+    $$PWD/danimationclock.cpp
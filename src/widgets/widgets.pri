@@ -55,6 +55,7 @@ HEADERS += $$PWD/dslider.h\
     $$PWD/dshortcutedit.h \
     $$PWD/dsimplelistview.h \
     $$PWD/dsimplelistitem.h \
+    $$PWD/dsimplelistdatasource.h \
     $$PWD/dexpandgroup.h \
     $$PWD/darrowrectangle.h \
     $$PWD/dgraphicsgloweffect.h \
@@ -142,6 +143,7 @@ SOURCES += $$PWD/dslider.cpp \
     $$PWD/dshortcutedit.cpp \
     $$PWD/dsimplelistview.cpp \
     $$PWD/dsimplelistitem.cpp \
+    $$PWD/dsimplelistdatasource.cpp \
     $$PWD/dexpandgroup.cpp \
     $$PWD/darrowrectangle.cpp \
     $$PWD/dgraphicsgloweffect.cpp \
@@ -227,6 +229,8 @@ includes.files += \
     $$PWD/DWaterProgress \
     $$PWD/DSimpleListView \
     $$PWD/DSimpleListItem \
+    $$PWD/DSimpleListDataSource \
+    $$PWD/DSimpleListDelegate \
     $$PWD/DSearchEdit \
     $$PWD/DPageIndicator \
     $$PWD/DSettingsWidgetFactory \